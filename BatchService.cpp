@@ -0,0 +1,85 @@
+#include "BatchService.h"
+#include <chrono>
+#include <istream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include "Solver.h"
+#include "ThreadPool.h"
+
+using namespace std;
+
+BatchService::BatchService(int threads) : thread_count(threads) {}
+
+vector<BatchResult> BatchService::run(const vector<BatchJob>& jobs) {
+    for (const auto& job : jobs) {
+        if (job.width <= 0 || job.height <= 0) {
+            throw invalid_argument("Batch job has a non-positive size");
+        }
+        if (!make_solver(job.solver)) {
+            throw invalid_argument("Batch job has unknown solver " + job.solver);
+        }
+    }
+
+    vector<BatchResult> results(jobs.size());
+    ThreadPool pool(thread_count);
+
+    // solvers by name for every worker, only touched by that worker
+    vector<map<string, unique_ptr<Solver>>> worker_solvers(pool.get_thread_count());
+
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        pool.submit([&, i](int worker) {
+            const BatchJob& job = jobs[i];
+            BatchResult& result = results[i];
+
+            // tasks must not throw, a failed job is reported in its result
+            try {
+                unique_ptr<Solver>& solver = worker_solvers[worker][job.solver];
+                if (!solver) {
+                    solver = make_solver(job.solver);
+                }
+
+                auto generate_start = chrono::steady_clock::now();
+                Maze maze(job.width, job.height, job.seed, job.generator, job.solver == "tree");
+                auto solve_start = chrono::steady_clock::now();
+                result.path = solver->solve(maze, maze.get_start_location(), maze.get_end_location());
+                auto solve_end = chrono::steady_clock::now();
+
+                result.generate_seconds = chrono::duration<double>(solve_start - generate_start).count();
+                result.solve_seconds = chrono::duration<double>(solve_end - solve_start).count();
+                result.nodes_expanded = solver->get_nodes_expanded();
+            } catch (const exception& error) {
+                result.error = error.what();
+            }
+        });
+    }
+
+    pool.wait();
+    return results;
+}
+
+vector<BatchJob> parse_batch_jobs(istream& in) {
+    vector<BatchJob> jobs;
+    string line;
+    int line_number = 0;
+
+    while (getline(in, line)) {
+        line_number++;
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        istringstream fields(line);
+        BatchJob job;
+        string generator;
+        if (!(fields >> job.width >> job.height >> job.seed >> generator >> job.solver)) {
+            throw invalid_argument("Could not parse batch job on line " + to_string(line_number));
+        }
+        if (!parse_generator(generator, job.generator)) {
+            throw invalid_argument("Unknown generator " + generator + " on line " + to_string(line_number));
+        }
+        jobs.push_back(job);
+    }
+    return jobs;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Maze.h"
+#include "Path.h"
+
+// one maze to generate and solve
+struct BatchJob {
+    int width = 0;
+    int height = 0;
+    uint64_t seed = 0;
+    Maze::Generator generator = Maze::Generator::DFS;
+    std::string solver = "dfs";
+};
+
+struct BatchResult {
+    Path path;
+    double generate_seconds = 0;
+    double solve_seconds = 0;
+    size_t nodes_expanded = 0;
+    // empty unless the job failed, e.g. ran out of memory
+    std::string error;
+};
+
+/*
+* Generates and solves many mazes in parallel on a work-stealing ThreadPool.
+*
+* Every maze has its own Random, and every worker keeps its own solvers (and with them their
+* workspaces), so jobs share no state and the batch scales with the number of cores.
+*/
+class BatchService {
+    int thread_count;
+
+public:
+    /*
+    * @param thread_count number of worker threads, 0 uses one per hardware thread
+    */
+    explicit BatchService(int thread_count = 0);
+
+    /*
+    * Runs every job and returns the results in the order of the jobs.
+    * Throws std::invalid_argument before running anything if a job has an unknown solver
+    * or a non-positive size.
+    */
+    std::vector<BatchResult> run(const std::vector<BatchJob>& jobs);
+};
+
+/*
+* Parses jobs, one per line as "width height seed generator solver", e.g. "100 100 42 prim astar".
+* Empty lines and lines starting with '#' are skipped.
+* Throws std::invalid_argument with the line number if a line can't be parsed.
+*/
+std::vector<BatchJob> parse_batch_jobs(std::istream& in);
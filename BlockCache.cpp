@@ -0,0 +1,132 @@
+#include "BlockCache.h"
+#include <algorithm>
+#include <assert.h>
+#include <cstring>
+#include <stdexcept>
+#include <unistd.h>
+#include "Instrument.h"
+
+using namespace std;
+
+BlockCache::BlockCache(int f, uint64_t offset, size_t block_bytes, uint64_t block_count, size_t slot_count, bool w)
+    : fd(f), file_offset(offset), block_words(block_bytes / sizeof(uint64_t)), writable(w),
+      capacity(min<uint64_t>(slot_count, block_count)), clock_hand(0), last_block(NO_BLOCK), last_slot(0) {
+    assert(block_bytes % sizeof(uint64_t) == 0);
+    assert(capacity > 0);
+    memory = make_unique<uint64_t[]>(capacity * block_words);
+    slots.reserve(capacity);
+    slot_of_block.reserve(capacity);
+    if (writable) {
+        on_disk.assign(block_count, false);
+    }
+    MAZE_COUNT_ALLOCATION(capacity * block_bytes);
+}
+
+uint64_t* BlockCache::get_slot_words(size_t slot) const {
+    return memory.get() + slot * block_words;
+}
+
+uint64_t* BlockCache::get(uint64_t block, bool dirty) {
+    assert(writable || !dirty);
+    size_t slot;
+    if (block == last_block) {
+        slot = last_slot;
+        stats.hits++;
+    } else {
+        auto found = slot_of_block.find(block);
+        if (found != slot_of_block.end()) {
+            slot = found->second;
+            stats.hits++;
+        } else {
+            stats.misses++;
+            slot = evict();
+            read_block(block, slot);
+            slots[slot].block = block;
+            slot_of_block[block] = slot;
+        }
+        last_block = block;
+        last_slot = slot;
+    }
+    slots[slot].referenced = true;
+    slots[slot].dirty |= dirty;
+    return get_slot_words(slot);
+}
+
+size_t BlockCache::evict() {
+    if (slots.size() < capacity) {
+        slots.push_back({NO_BLOCK, false, false});
+        return slots.size() - 1;
+    }
+
+    // CLOCK: clear reference bits until a slot that wasn't used since the last sweep comes up
+    while (slots[clock_hand].referenced) {
+        slots[clock_hand].referenced = false;
+        clock_hand = (clock_hand + 1) % slots.size();
+    }
+    size_t slot = clock_hand;
+    clock_hand = (clock_hand + 1) % slots.size();
+
+    if (slots[slot].dirty) {
+        write_block(slot);
+    }
+    slot_of_block.erase(slots[slot].block);
+    if (last_block == slots[slot].block) {
+        last_block = NO_BLOCK;
+    }
+    return slot;
+}
+
+void BlockCache::read_block(uint64_t block, size_t slot) {
+    uint64_t* words = get_slot_words(slot);
+    size_t bytes = block_words * sizeof(uint64_t);
+    if (writable && !on_disk[block]) {
+        memset(words, 0, bytes);
+        return;
+    }
+
+    off_t position = file_offset + block * bytes;
+    size_t done = 0;
+    while (done < bytes) {
+        ssize_t count = pread(fd, reinterpret_cast<char*>(words) + done, bytes - done, position + done);
+        if (count <= 0) {
+            throw runtime_error("Could not read block " + to_string(block));
+        }
+        done += count;
+    }
+    stats.blocks_read++;
+}
+
+void BlockCache::write_block(size_t slot) {
+    uint64_t block = slots[slot].block;
+    const uint64_t* words = get_slot_words(slot);
+    size_t bytes = block_words * sizeof(uint64_t);
+
+    off_t position = file_offset + block * bytes;
+    size_t done = 0;
+    while (done < bytes) {
+        ssize_t count = pwrite(fd, reinterpret_cast<const char*>(words) + done, bytes - done, position + done);
+        if (count <= 0) {
+            throw runtime_error("Could not write block " + to_string(block));
+        }
+        done += count;
+    }
+    on_disk[block] = true;
+    slots[slot].dirty = false;
+    stats.blocks_written++;
+}
+
+void BlockCache::flush() {
+    for (size_t slot = 0; slot < slots.size(); ++slot) {
+        if (slots[slot].dirty) {
+            write_block(slot);
+        }
+    }
+}
+
+size_t BlockCache::get_capacity() const {
+    return capacity;
+}
+
+const BlockCache::Stats& BlockCache::get_stats() const {
+    return stats;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+/*
+* Fixed-size blocks of a file paged in and out through a bounded number of memory slots.
+*
+* A miss reads the block with pread into a free slot, or into the slot picked by the CLOCK
+* algorithm (a slot used since the last sweep gets a second chance). Dirty blocks are written
+* back with pwrite when they are evicted or flushed. A writable cache starts from an empty
+* scratch file: blocks that were never written back read as zeros without touching the disk.
+* Dirty blocks still cached when the cache is destroyed are dropped, not written, since scratch
+* data is useless once nobody reads it. Call flush() first to keep them.
+*
+* The last block returned is remembered, so repeated accesses to one block skip the lookup.
+* A pointer from get() stays valid until the next call to get().
+*/
+class BlockCache {
+public:
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t blocks_read = 0;
+        uint64_t blocks_written = 0;
+    };
+
+private:
+    struct Slot {
+        uint64_t block;
+        bool referenced;
+        bool dirty;
+    };
+
+    int fd;
+    uint64_t file_offset;
+    size_t block_words;
+    bool writable;
+    size_t capacity;
+    std::unique_ptr<uint64_t[]> memory;
+    std::vector<Slot> slots;
+    std::unordered_map<uint64_t, size_t> slot_of_block;
+    // blocks a writable cache has written to the file at least once
+    std::vector<bool> on_disk;
+    size_t clock_hand;
+    uint64_t last_block;
+    size_t last_slot;
+    Stats stats;
+
+    uint64_t* get_slot_words(size_t slot) const;
+
+    // picks the slot for a missed block, writing back the block it held if that is dirty
+    size_t evict();
+
+    void read_block(uint64_t block, size_t slot);
+    void write_block(size_t slot);
+
+public:
+    static const uint64_t NO_BLOCK = UINT64_MAX;
+
+    /*
+    * Initializes the cache. The file descriptor stays owned by the caller.
+    * @param file_offset byte offset of block 0 in the file
+    * @param block_bytes size of a block, a multiple of 8
+    * @param block_count number of blocks in the file
+    * @param slot_count number of blocks kept in memory, at least 1
+    * @param writable true for a scratch file that starts empty and is written back
+    */
+    BlockCache(int fd, uint64_t file_offset, size_t block_bytes, uint64_t block_count, size_t slot_count, bool writable);
+
+    BlockCache(const BlockCache&) = delete;
+    BlockCache& operator=(const BlockCache&) = delete;
+
+    /*
+    * Returns the words of a block, reading it on a miss.
+    * Throws std::runtime_error if the file can't be read or written.
+    * @param dirty true if the caller writes to the block, a read-only cache must not be written
+    */
+    uint64_t* get(uint64_t block, bool dirty = false);
+
+    // writes every dirty block back, throws std::runtime_error if that fails
+    void flush();
+
+    size_t get_capacity() const;
+    const Stats& get_stats() const;
+};
@@ -0,0 +1,38 @@
+#include "DisjointSet.h"
+#include "Instrument.h"
+#include <assert.h>
+#include <numeric>
+
+using namespace std;
+
+DisjointSet::DisjointSet(size_t size) : parent(size), rank(size, 0) {
+    assert(size <= UINT32_MAX);
+    iota(parent.begin(), parent.end(), 0);
+    MAZE_COUNT_ALLOCATION(size * (sizeof(uint32_t) + sizeof(rank[0])));
+}
+
+uint32_t DisjointSet::find(uint32_t element) {
+    while (parent[element] != element) {
+        // path halving, point every other node at its grandparent
+        parent[element] = parent[parent[element]];
+        element = parent[element];
+    }
+    return element;
+}
+
+bool DisjointSet::unite(uint32_t a, uint32_t b) {
+    a = find(a);
+    b = find(b);
+    if (a == b) {
+        return false;
+    }
+    if (rank[a] < rank[b]) {
+        parent[a] = b;
+    } else if (rank[a] > rank[b]) {
+        parent[b] = a;
+    } else {
+        parent[b] = a;
+        rank[a]++;
+    }
+    return true;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+* Disjoint-set (union-find) over the flat cell indices 0..size-1.
+* Uses union by rank and path halving, so operations are effectively O(1).
+*/
+class DisjointSet {
+    std::vector<uint32_t> parent;
+    std::vector<uint8_t> rank;
+
+public:
+    /*
+    * Initializes size singleton sets.
+    * @param size number of elements, must fit in 32 bits
+    */
+    explicit DisjointSet(size_t size);
+
+    // returns the representative of the set containing element
+    uint32_t find(uint32_t element);
+
+    /*
+    * Merges the sets containing a and b.
+    * @return false if they were already in the same set.
+    */
+    bool unite(uint32_t a, uint32_t b);
+};
@@ -0,0 +1,180 @@
+#include "DistanceField.h"
+#include "Instrument.h"
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+using namespace std;
+
+using Side = Maze::Side;
+
+static const int STEPS_PER_WORD = 32;
+
+// header of a saved field, the distances and next step words follow it
+struct DistanceFieldHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    int32_t width;
+    int32_t height;
+    int32_t target_row;
+    int32_t target_col;
+    uint64_t wall_hash;
+    uint64_t reserved[3];
+};
+
+static_assert(sizeof(DistanceFieldHeader) == 64, "distance field header must stay 64 bytes");
+
+static const char DISTANCE_FIELD_MAGIC[8] = {'M', 'A', 'Z', 'E', 'D', 'I', 'S', 'T'};
+static const uint32_t DISTANCE_FIELD_VERSION = 1;
+
+DistanceField::DistanceField()
+    : height(0), width(0), target(0, 0), maze_id(0), revision(0), wall_hash(0) {}
+
+DistanceField::DistanceField(const Maze& maze, pair<int,int> t)
+    : height(maze.get_height()), width(maze.get_width()), target(t), maze_id(maze.get_id()),
+      revision(maze.get_revision()), wall_hash(maze.get_wall_hash()) {
+    MAZE_PHASE(Phase::INDEX);
+    const Side sides[] = {Side::TOP, Side::RIGHT, Side::BOTTOM, Side::LEFT};
+    size_t cell_count = static_cast<size_t>(height) * width;
+    if (cell_count >= UNREACHABLE) {
+        throw invalid_argument("Maze is too large for a distance field");
+    }
+
+    distances.assign(cell_count, UNREACHABLE);
+    next_steps.assign((cell_count + STEPS_PER_WORD - 1) / STEPS_PER_WORD, 0);
+    // every cell is pushed once, so the distances double as the visited set
+    vector<uint32_t> queue;
+    queue.reserve(cell_count);
+    MAZE_COUNT_ALLOCATION(cell_count * (sizeof(uint32_t) * 2) + next_steps.size() * sizeof(uint64_t));
+
+    uint32_t target_index = get_index(target);
+    distances[target_index] = 0;
+    queue.push_back(target_index);
+
+    for (size_t head = 0; head < queue.size(); ++head) {
+        uint32_t index = queue[head];
+        MAZE_COUNT_VISIT(index);
+        uint32_t distance = distances[index] + 1;
+        int row = index / width;
+        int col = index % width;
+        for (Side side : sides) {
+            if (!maze.is_passage_open(row, col, side)) {
+                continue;
+            }
+            uint32_t neighbor = index + maze.get_index_offset(side);
+            if (distances[neighbor] != UNREACHABLE) {
+                continue;
+            }
+            distances[neighbor] = distance;
+            // the neighbor moves back the way the search came
+            int shift = 2 * (neighbor % STEPS_PER_WORD);
+            next_steps[neighbor / STEPS_PER_WORD] |= static_cast<uint64_t>(Maze::get_opposite_side(side)) << shift;
+            queue.push_back(neighbor);
+        }
+        MAZE_TRACK_FRONTIER(queue.size() - head);
+    }
+}
+
+size_t DistanceField::get_index(pair<int,int> cell) const {
+    return static_cast<size_t>(cell.first) * width + cell.second;
+}
+
+pair<int,int> DistanceField::get_target() const {
+    return target;
+}
+
+bool DistanceField::is_valid(const Maze& maze) const {
+    return maze.get_id() == maze_id && maze.get_revision() == revision;
+}
+
+uint32_t DistanceField::get_distance(pair<int,int> cell) const {
+    return distances[get_index(cell)];
+}
+
+Path::Step DistanceField::get_next_step(pair<int,int> cell) const {
+    size_t index = get_index(cell);
+    return Path::Step((next_steps[index / STEPS_PER_WORD] >> (2 * (index % STEPS_PER_WORD))) & 3);
+}
+
+pair<int,int> DistanceField::get_next_cell(pair<int,int> cell) const {
+    if (cell == target) {
+        return cell;
+    }
+    return Path::get_neighbor(cell, get_next_step(cell));
+}
+
+Path DistanceField::get_path(pair<int,int> from) const {
+    uint32_t distance = get_distance(from);
+    if (distance == UNREACHABLE) {
+        return Path();
+    }
+    Path path(from);
+    for (pair<int,int> cell = from; distance > 0; --distance) {
+        Path::Step step = get_next_step(cell);
+        path.add_step(step);
+        cell = Path::get_neighbor(cell, step);
+    }
+    return path;
+}
+
+void DistanceField::save(const string& filename) const {
+    DistanceFieldHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, DISTANCE_FIELD_MAGIC, sizeof(header.magic));
+    header.version = DISTANCE_FIELD_VERSION;
+    header.header_size = sizeof(DistanceFieldHeader);
+    header.width = width;
+    header.height = height;
+    header.target_row = target.first;
+    header.target_col = target.second;
+    header.wall_hash = wall_hash;
+
+    ofstream out(filename, ios::binary);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(distances.data()), distances.size() * sizeof(uint32_t));
+    out.write(reinterpret_cast<const char*>(next_steps.data()), next_steps.size() * sizeof(uint64_t));
+    out.close();
+    if (!out) {
+        throw runtime_error("Could not write distance field " + filename);
+    }
+}
+
+DistanceField DistanceField::load(const string& filename, const Maze& maze) {
+    ifstream in(filename, ios::binary);
+    if (!in) {
+        throw runtime_error("Could not open " + filename);
+    }
+    DistanceFieldHeader header;
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header))
+        || memcmp(header.magic, DISTANCE_FIELD_MAGIC, sizeof(header.magic)) != 0) {
+        throw runtime_error("Not a distance field");
+    }
+    if (header.version != DISTANCE_FIELD_VERSION || header.header_size != sizeof(DistanceFieldHeader)) {
+        throw runtime_error("Unsupported distance field version " + to_string(header.version));
+    }
+    if (header.width != maze.get_width() || header.height != maze.get_height()
+        || header.wall_hash != maze.get_wall_hash()) {
+        throw runtime_error("Distance field " + filename + " was saved for different walls");
+    }
+    if (header.target_row < 0 || header.target_row >= header.height || header.target_col < 0 || header.target_col >= header.width) {
+        throw runtime_error("Distance field has its target outside of the maze");
+    }
+
+    DistanceField field;
+    field.height = header.height;
+    field.width = header.width;
+    field.target = make_pair(header.target_row, header.target_col);
+    field.maze_id = maze.get_id();
+    field.revision = maze.get_revision();
+    field.wall_hash = header.wall_hash;
+    size_t cell_count = static_cast<size_t>(field.height) * field.width;
+    field.distances.resize(cell_count);
+    field.next_steps.resize((cell_count + STEPS_PER_WORD - 1) / STEPS_PER_WORD);
+    in.read(reinterpret_cast<char*>(field.distances.data()), field.distances.size() * sizeof(uint32_t));
+    in.read(reinterpret_cast<char*>(field.next_steps.data()), field.next_steps.size() * sizeof(uint64_t));
+    if (!in) {
+        throw runtime_error("Distance field " + filename + " is truncated");
+    }
+    return field;
+}
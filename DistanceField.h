@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Maze.h"
+#include "Path.h"
+
+/*
+* Distance and next step towards one target cell for every cell of a maze, built by a single
+* breadth first search from the target.
+*
+* Distances are a flat array of 32 bit values and next steps a flat array of 2 bit Path::Steps,
+* 4.25 bytes per cell, so any number of agents can look up how far they are and where to move
+* in O(1) per step without searching.
+*
+* The field remembers the maze (by Maze::get_id) and revision it was built from. Any wall edit
+* bumps the revision, so is_valid() tells when the field has to be rebuilt. Saved fields carry a
+* hash of the walls and only load for a maze with the same walls.
+*/
+class DistanceField {
+    int height;
+    int width;
+    std::pair<int,int> target;
+    uint64_t maze_id;
+    uint64_t revision;
+    uint64_t wall_hash;
+    std::vector<uint32_t> distances;
+    // step i is bits 2 * (i % 32) of word i / 32, like the steps of a Path
+    std::vector<uint64_t> next_steps;
+
+    DistanceField();
+
+    size_t get_index(std::pair<int,int> cell) const;
+
+public:
+    static constexpr uint32_t UNREACHABLE = UINT32_MAX;
+
+    /*
+    * Builds the field of every cell towards target.
+    * Throws std::invalid_argument if the maze is too large.
+    */
+    DistanceField(const Maze& maze, std::pair<int,int> target);
+
+    std::pair<int,int> get_target() const;
+
+    // returns true if the field was built from this maze and no wall changed since
+    bool is_valid(const Maze& maze) const;
+
+    // returns number of steps from the cell to the target, or UNREACHABLE
+    uint32_t get_distance(std::pair<int,int> cell) const;
+
+    // returns the first step of a shortest path to the target, the cell must reach the target
+    Path::Step get_next_step(std::pair<int,int> cell) const;
+
+    // returns the cell one step closer to the target, the target itself stays put
+    std::pair<int,int> get_next_cell(std::pair<int,int> cell) const;
+
+    // returns the path from the cell to the target, or an empty path if it can't be reached
+    Path get_path(std::pair<int,int> from) const;
+
+    /*
+    * Writes the field to a file: a 64 byte header followed by the distances and next steps.
+    * Throws std::runtime_error if the file can't be written.
+    */
+    void save(const std::string& filename) const;
+
+    /*
+    * Reads a field saved for a maze with the same walls.
+    * Throws std::runtime_error if the file can't be read, is not a field, or was saved for
+    * different walls.
+    */
+    static DistanceField load(const std::string& filename, const Maze& maze);
+};
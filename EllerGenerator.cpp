@@ -0,0 +1,113 @@
+#include "EllerGenerator.h"
+#include <assert.h>
+#include <string>
+
+using namespace std;
+
+EllerGenerator::EllerGenerator(int w, int h, uint64_t seed)
+    : width(w), height(h), row(0), random(seed), random_bits(0), random_bits_left(0),
+      left(w), right(w) {
+    assert(width > 0);
+    assert(height > 0);
+    // every cell of the first row starts in its own set
+    for (int col = 0; col < width; ++col) {
+        left[col] = col;
+        right[col] = col;
+    }
+}
+
+int EllerGenerator::get_width() const {
+    return width;
+}
+
+int EllerGenerator::get_height() const {
+    return height;
+}
+
+int EllerGenerator::get_row() const {
+    return row;
+}
+
+bool EllerGenerator::has_next_row() const {
+    return row < height;
+}
+
+bool EllerGenerator::next_bit() {
+    if (random_bits_left == 0) {
+        random_bits = random.next();
+        random_bits_left = 64;
+    }
+    bool bit = random_bits & 1;
+    random_bits >>= 1;
+    random_bits_left--;
+    return bit;
+}
+
+void EllerGenerator::join_with_right(int col) {
+    // splice the list of col + 1 in after col
+    right[left[col + 1]] = right[col];
+    left[right[col]] = left[col + 1];
+    right[col] = col + 1;
+    left[col + 1] = col;
+}
+
+void EllerGenerator::detach(int col) {
+    left[right[col]] = left[col];
+    right[left[col]] = right[col];
+    left[col] = col;
+    right[col] = col;
+}
+
+void EllerGenerator::next_row(vector<uint8_t>& walls) {
+    assert(has_next_row());
+    walls.assign(width, 0);
+    bool last_row = row == height - 1;
+
+    for (int col = 0; col < width; ++col) {
+        // east wall, only cells of different sets can be joined or there would be a loop
+        bool can_join = col < width - 1 && right[col] != col + 1;
+        if (can_join && (last_row || next_bit())) {
+            join_with_right(col);
+        } else {
+            walls[col] |= EAST_WALL;
+        }
+
+        // south wall, a set must keep at least one passage down so a cell alone in its set
+        // always stays open. a walled cell starts a new set in the next row.
+        if (last_row) {
+            walls[col] |= SOUTH_WALL;
+        } else if (left[col] != col && next_bit()) {
+            detach(col);
+            walls[col] |= SOUTH_WALL;
+        }
+    }
+
+    row++;
+}
+
+void write_ascii_maze(EllerGenerator& generator, ostream& out) {
+    int width = generator.get_width();
+    vector<uint8_t> walls;
+    string line(2 * width + 1, '#');
+
+    // top border
+    out << line << '\n';
+
+    while (generator.has_next_row()) {
+        generator.next_row(walls);
+
+        // cells and east walls
+        for (int col = 0; col < width; ++col) {
+            line[2 * col + 1] = ' ';
+            line[2 * col + 2] = (walls[col] & EllerGenerator::EAST_WALL) ? '#' : ' ';
+        }
+        out << line << '\n';
+
+        // south walls and corner posts
+        for (int col = 0; col < width; ++col) {
+            line[2 * col + 1] = (walls[col] & EllerGenerator::SOUTH_WALL) ? '#' : ' ';
+            line[2 * col + 2] = '#';
+        }
+        out << line << '\n';
+    }
+}
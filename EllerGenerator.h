@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+#include "Random.h"
+
+/*
+* Streaming maze generator based on Eller's algorithm.
+*
+* Produces the maze one row at a time and only keeps state for the current row, so memory is
+* proportional to the width no matter how many rows are generated. The result is a perfect maze.
+*
+* Sets of connected cells are kept as circular lists ordered by column (left / right arrays),
+* so two neighbours are in the same set exactly when right[col] == col + 1 and every row is O(width).
+*/
+class EllerGenerator {
+    int width;
+    int height;
+    int row;
+    Random random;
+    uint64_t random_bits;
+    int random_bits_left;
+    std::vector<int> left;
+    std::vector<int> right;
+
+    // returns a fair random bit, drawing 64 at a time from the generator
+    bool next_bit();
+
+    // joins the sets of col and col + 1
+    void join_with_right(int col);
+
+    // removes col from its set, leaving it alone
+    void detach(int col);
+
+public:
+    // bits of a cell in a generated row, same as the right and bottom wall bits of WallGrid
+    static const uint8_t EAST_WALL = 1;
+    static const uint8_t SOUTH_WALL = 2;
+
+    /*
+    * Initializes the generator.
+    * @param width number of cells in a row
+    * @param height number of rows to generate
+    * @param seed seed for the random generator
+    */
+    EllerGenerator(int width, int height, uint64_t seed);
+
+    int get_width() const;
+    int get_height() const;
+
+    // returns the index of the row the next call to next_row generates
+    int get_row() const;
+
+    bool has_next_row() const;
+
+    /*
+    * Generates the next row.
+    * @param walls resized to width, each cell is a combination of EAST_WALL and SOUTH_WALL.
+    * The east wall of the last cell and the south walls of the last row are the maze border.
+    */
+    void next_row(std::vector<uint8_t>& walls);
+};
+
+/*
+* Generates the whole maze and streams it to out as text, in the raw layout used by Maze
+* ('#' for walls, ' ' for passages), two lines per row.
+*/
+void write_ascii_maze(EllerGenerator& generator, std::ostream& out);
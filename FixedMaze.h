@@ -0,0 +1,257 @@
+#pragma once
+
+#include <array>
+#include <assert.h>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include "Instrument.h"
+#include "Maze.h"
+#include "MazeAlgorithms.h"
+#include "Path.h"
+#include "Random.h"
+
+/*
+* Fixed capacity array with the push_back, size and operator[] of a vector, used as the queue
+* of the shared algorithms without touching the heap.
+*/
+template <class T, size_t CAPACITY>
+class FixedVector {
+    std::array<T, CAPACITY> items;
+    size_t count = 0;
+
+public:
+    void push_back(T item) {
+        assert(count < CAPACITY);
+        items[count++] = item;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    T& operator[](size_t i) {
+        return items[i];
+    }
+
+    const T& operator[](size_t i) const {
+        return items[i];
+    }
+
+    void clear() {
+        count = 0;
+    }
+};
+
+/*
+* Visited bits and parent directions for CELL_COUNT cells, the SolverWorkspace of a FixedMaze.
+*/
+template <size_t CELL_COUNT>
+class FixedSolverWorkspace {
+    std::bitset<CELL_COUNT> visited;
+    std::array<uint8_t, CELL_COUNT> parent;
+
+public:
+    void reset() {
+        visited.reset();
+    }
+
+    bool is_visited(size_t index) const {
+        return visited[index];
+    }
+
+    void mark_visited(size_t index) {
+        visited[index] = true;
+        MAZE_COUNT_VISIT(index);
+    }
+
+    uint8_t get_parent(size_t index) const {
+        return parent[index];
+    }
+
+    void set_parent(size_t index, uint8_t direction) {
+        parent[index] = direction;
+    }
+};
+
+/*
+* A maze whose size is known at compile time, for hot workloads on a few small sizes.
+*
+* Walls use the WallGrid layout (east and south wall of every cell, 2 bits per cell) in a
+* std::array, so a FixedMaze lives on the stack or inline in another object. Strides and
+* neighbor offsets are constants, and the accessors only check their arguments with assert,
+* which release builds (-DNDEBUG) compile out.
+*
+* Generation and solving use the same templates as Maze (see MazeAlgorithms.h), and a FixedMaze
+* built from a seed has the same walls as Maze(W, H, seed, Maze::Generator::PRIM).
+*/
+template <int W, int H>
+class FixedMaze {
+    static_assert(W > 0 && H > 0, "a maze needs at least one cell");
+    // scratch memory of generation and solving is on the stack
+    static_assert(static_cast<size_t>(W) * H <= 65536, "FixedMaze is meant for small mazes");
+
+public:
+    using Side = Maze::Side;
+
+    static constexpr int WIDTH = W;
+    static constexpr int HEIGHT = H;
+    static constexpr size_t CELL_COUNT = static_cast<size_t>(W) * H;
+    static constexpr size_t WALL_WORD_COUNT = (CELL_COUNT + 31) / 32;
+
+private:
+    static const int EAST_BIT = 0;
+    static const int SOUTH_BIT = 1;
+
+    std::array<uint64_t, WALL_WORD_COUNT> walls;
+
+    static constexpr size_t get_index(int row, int col) {
+        return static_cast<size_t>(row) * W + col;
+    }
+
+    bool get_wall_bit(int row, int col, int bit) const {
+        assert(row >= 0 && row < H && col >= 0 && col < W);
+        size_t index = get_index(row, col);
+        return (walls[index >> 5] >> (((index & 31) << 1) + bit)) & 1;
+    }
+
+    void clear_wall_bit(int row, int col, int bit) {
+        assert(row >= 0 && row < H && col >= 0 && col < W);
+        size_t index = get_index(row, col);
+        walls[index >> 5] &= ~(uint64_t(1) << (((index & 31) << 1) + bit));
+    }
+
+public:
+    /*
+    * Initializes a maze generated with randomized Prim from the seed.
+    */
+    explicit FixedMaze(uint64_t seed) {
+        walls.fill(~uint64_t(0));
+        Random random(seed);
+        std::array<uint8_t, CELL_COUNT> state;
+        std::array<size_t, CELL_COUNT> frontier;
+        generate_prim(*this, random, state.data(), frontier.data());
+    }
+
+    constexpr int get_height() const {
+        return H;
+    }
+
+    constexpr int get_width() const {
+        return W;
+    }
+
+    constexpr std::pair<int,int> get_start_location() const {
+        return std::make_pair(0, 0);
+    }
+
+    constexpr std::pair<int,int> get_end_location() const {
+        return std::make_pair(H - 1, W - 1);
+    }
+
+    static constexpr ptrdiff_t get_index_offset(Side side) {
+        return side == Side::TOP ? -static_cast<ptrdiff_t>(W)
+            : side == Side::BOTTOM ? W
+            : side == Side::LEFT ? -1 : 1;
+    }
+
+    bool has_east_wall(int row, int col) const {
+        return get_wall_bit(row, col, EAST_BIT);
+    }
+
+    bool has_south_wall(int row, int col) const {
+        return get_wall_bit(row, col, SOUTH_BIT);
+    }
+
+    // returns true if the cell has a neighbor on that side
+    bool has_neighbor(int row, int col, Side side) const {
+        switch (side) {
+            case Side::TOP:
+                return row > 0;
+            case Side::BOTTOM:
+                return row < H - 1;
+            case Side::LEFT:
+                return col > 0;
+            case Side::RIGHT:
+                return col < W - 1;
+        }
+        return false;
+    }
+
+    // returns true if the cell has a neighbor on that side and no wall in between
+    bool is_passage_open(int row, int col, Side side) const {
+        switch (side) {
+            case Side::TOP:
+                return row > 0 && !has_south_wall(row - 1, col);
+            case Side::BOTTOM:
+                return row < H - 1 && !has_south_wall(row, col);
+            case Side::LEFT:
+                return col > 0 && !has_east_wall(row, col - 1);
+            case Side::RIGHT:
+                return col < W - 1 && !has_east_wall(row, col);
+        }
+        return false;
+    }
+
+    // removes the wall on the given side of the cell, the neighbor must exist
+    void open_passage(int row, int col, Side side) {
+        switch (side) {
+            case Side::TOP:
+                clear_wall_bit(row - 1, col, SOUTH_BIT);
+                break;
+            case Side::BOTTOM:
+                clear_wall_bit(row, col, SOUTH_BIT);
+                break;
+            case Side::LEFT:
+                clear_wall_bit(row, col - 1, EAST_BIT);
+                break;
+            case Side::RIGHT:
+                clear_wall_bit(row, col, EAST_BIT);
+                break;
+        }
+    }
+
+    /*
+    * Returns the length in cells of the shortest path between two cells, 0 if there is none.
+    * Runs breadth first search on the stack without allocating.
+    */
+    size_t get_path_length(std::pair<int,int> start, std::pair<int,int> end) const {
+        FixedSolverWorkspace<CELL_COUNT> workspace;
+        size_t start_index = get_index(start.first, start.second);
+        size_t end_index = get_index(end.first, end.second);
+        if (!search(start_index, end_index, workspace)) {
+            return 0;
+        }
+
+        size_t length = 1;
+        for (size_t index = end_index; index != start_index; ++length) {
+            index += get_index_offset(Side(workspace.get_parent(index)));
+        }
+        return length;
+    }
+
+    /*
+    * Solves with breadth first search on the stack, only the returned Path allocates.
+    */
+    Path solve(std::pair<int,int> start, std::pair<int,int> end) const {
+        FixedSolverWorkspace<CELL_COUNT> workspace;
+        size_t start_index = get_index(start.first, start.second);
+        size_t end_index = get_index(end.first, end.second);
+        if (!search(start_index, end_index, workspace)) {
+            return Path();
+        }
+
+        Path path;
+        append_parent_chain(*this, workspace, end_index, start_index, path);
+        path.reverse();
+        return path;
+    }
+
+private:
+    bool search(size_t start_index, size_t end_index, FixedSolverWorkspace<CELL_COUNT>& workspace) const {
+        workspace.reset();
+        FixedVector<size_t, CELL_COUNT> queue;
+        size_t nodes_expanded = 0;
+        return breadth_first_search(*this, start_index, end_index, workspace, queue, nodes_expanded);
+    }
+};
@@ -0,0 +1,541 @@
+#include "HPAIndex.h"
+#include "Instrument.h"
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+
+using namespace std;
+
+using Side = Maze::Side;
+
+static const Side SIDES[] = {Side::TOP, Side::RIGHT, Side::BOTTOM, Side::LEFT};
+
+HPAIndex::HPAIndex(const Maze& m, int size)
+    : maze(&m), height(m.get_height()), width(m.get_width()), cluster_size(size),
+      revision(m.get_revision()), local_search(0), abstract_search(0) {
+    MAZE_PHASE(Phase::INDEX);
+    if (cluster_size < 1 || cluster_size > 255) {
+        throw invalid_argument("Cluster size must be between 1 and 255");
+    }
+    clusters_across = (width + cluster_size - 1) / cluster_size;
+    clusters_down = (height + cluster_size - 1) / cluster_size;
+    size_t cluster_count = static_cast<size_t>(clusters_across) * clusters_down;
+    size_t slot_count = cluster_count * get_slots_per_cluster();
+    if (static_cast<size_t>(height) * width >= UNREACHED || slot_count + 2 >= UNREACHED) {
+        throw invalid_argument("Maze is too large for a hierarchical index");
+    }
+
+    size_t cluster_cells = static_cast<size_t>(cluster_size) * cluster_size;
+    local_stamp.assign(cluster_cells, 0);
+    local_distance.assign(cluster_cells, 0);
+    local_parent.assign(cluster_cells, 0);
+    local_queue.reserve(cluster_cells);
+    // two extra nodes for the cells of a query
+    node_stamp.assign(slot_count + 2, 0);
+    node_distance.assign(slot_count + 2, 0);
+    node_parent.assign(slot_count + 2, 0);
+    MAZE_COUNT_ALLOCATION((slot_count + 2) * 3 * sizeof(uint32_t));
+
+    clusters.resize(cluster_count);
+    vector<size_t> all(cluster_count);
+    for (size_t cluster = 0; cluster < cluster_count; ++cluster) {
+        all[cluster] = cluster;
+    }
+    rebuild(all);
+    compute_landmarks();
+}
+
+size_t HPAIndex::get_index(pair<int,int> cell) const {
+    return static_cast<size_t>(cell.first) * width + cell.second;
+}
+
+pair<int,int> HPAIndex::get_cell(size_t index) const {
+    return make_pair(static_cast<int>(index / width), static_cast<int>(index % width));
+}
+
+size_t HPAIndex::get_cluster(uint32_t index) const {
+    int row = index / width;
+    int col = index % width;
+    return static_cast<size_t>(row / cluster_size) * clusters_across + col / cluster_size;
+}
+
+size_t HPAIndex::get_slots_per_cluster() const {
+    return 4 * static_cast<size_t>(cluster_size);
+}
+
+void HPAIndex::build_cluster(size_t cluster) {
+    Cluster& c = clusters[cluster];
+    c.entrances.clear();
+
+    int first_row = cluster / clusters_across * cluster_size;
+    int first_col = cluster % clusters_across * cluster_size;
+    int last_row = min(first_row + cluster_size, height) - 1;
+    int last_col = min(first_col + cluster_size, width) - 1;
+
+    // only border cells can have a passage out of the cluster
+    for (int row = first_row; row <= last_row; ++row) {
+        for (int col = first_col; col <= last_col; ++col) {
+            bool open_out = (row == first_row && maze->is_passage_open(row, col, Side::TOP))
+                || (row == last_row && maze->is_passage_open(row, col, Side::BOTTOM))
+                || (col == first_col && maze->is_passage_open(row, col, Side::LEFT))
+                || (col == last_col && maze->is_passage_open(row, col, Side::RIGHT));
+            if (open_out) {
+                c.entrances.push_back(get_index(make_pair(row, col)));
+            }
+            if (row != first_row && row != last_row && col == first_col) {
+                col = max(col, last_col - 1);
+            }
+        }
+    }
+
+    size_t count = c.entrances.size();
+    vector<uint16_t> distances(count * count);
+    for (size_t i = 0; i < count; ++i) {
+        search_cluster(c.entrances[i]);
+        for (size_t j = 0; j < count; ++j) {
+            distances[i * count + j] = get_local_distance(c.entrances[j]);
+        }
+    }
+
+    // an edge that a third entrance splits into two edges of the same total is redundant, the
+    // abstract search still finds that distance and expands fewer edges per node
+    c.edge_offsets.assign(1, 0);
+    c.edges.clear();
+    for (size_t i = 0; i < count; ++i) {
+        for (size_t j = 0; j < count; ++j) {
+            uint16_t distance = distances[i * count + j];
+            if (j == i || distance == UNREACHABLE) {
+                continue;
+            }
+            bool redundant = false;
+            for (size_t k = 0; k < count && !redundant; ++k) {
+                redundant = k != i && k != j && distances[i * count + k] != UNREACHABLE
+                    && distances[k * count + j] != UNREACHABLE
+                    && distances[i * count + k] + distances[k * count + j] == distance;
+            }
+            if (!redundant) {
+                c.edges.push_back({static_cast<uint16_t>(j), distance});
+            }
+        }
+        c.edge_offsets.push_back(c.edges.size());
+    }
+}
+
+void HPAIndex::link_cluster(size_t cluster) {
+    Cluster& c = clusters[cluster];
+    c.links.assign(2 * c.entrances.size(), NO_NODE);
+    for (size_t i = 0; i < c.entrances.size(); ++i) {
+        uint32_t index = c.entrances[i];
+        int row = index / width;
+        int col = index % width;
+        // a corner cell can have passages out of two sides
+        int link = 0;
+        for (Side side : SIDES) {
+            if (!maze->is_passage_open(row, col, side)) {
+                continue;
+            }
+            uint32_t neighbor = index + maze->get_index_offset(side);
+            if (get_cluster(neighbor) != cluster) {
+                c.links[2 * i + link++] = get_node(neighbor);
+            }
+        }
+    }
+}
+
+void HPAIndex::rebuild(const vector<size_t>& changed) {
+    for (size_t cluster : changed) {
+        build_cluster(cluster);
+    }
+
+    // entrances of a rebuilt cluster can move to other slots, so the links into it change too
+    vector<size_t> relink;
+    for (size_t cluster : changed) {
+        int cluster_row = cluster / clusters_across;
+        int cluster_col = cluster % clusters_across;
+        relink.push_back(cluster);
+        if (cluster_row > 0) {
+            relink.push_back(cluster - clusters_across);
+        }
+        if (cluster_row < clusters_down - 1) {
+            relink.push_back(cluster + clusters_across);
+        }
+        if (cluster_col > 0) {
+            relink.push_back(cluster - 1);
+        }
+        if (cluster_col < clusters_across - 1) {
+            relink.push_back(cluster + 1);
+        }
+    }
+    sort(relink.begin(), relink.end());
+    relink.erase(unique(relink.begin(), relink.end()), relink.end());
+    for (size_t cluster : relink) {
+        link_cluster(cluster);
+    }
+}
+
+void HPAIndex::search_cluster(uint32_t from, uint32_t until) {
+    if (++local_search == 0) {
+        // the stamps wrapped around, old ones could look current
+        fill(local_stamp.begin(), local_stamp.end(), 0);
+        local_search = 1;
+    }
+
+    size_t cluster = get_cluster(from);
+    int first_row = cluster / clusters_across * cluster_size;
+    int first_col = cluster % clusters_across * cluster_size;
+    auto get_local = [&](uint32_t index) {
+        return (index / width - first_row) * cluster_size + (index % width - first_col);
+    };
+
+    local_queue.clear();
+    local_queue.push_back(from);
+    size_t local = get_local(from);
+    local_stamp[local] = local_search;
+    local_distance[local] = 0;
+
+    for (size_t head = 0; head < local_queue.size(); ++head) {
+        uint32_t index = local_queue[head];
+        MAZE_COUNT_VISIT(index);
+        if (index == until) {
+            break;
+        }
+        uint16_t distance = local_distance[get_local(index)];
+        int row = index / width;
+        int col = index % width;
+        for (Side side : SIDES) {
+            if (!maze->is_passage_open(row, col, side)) {
+                continue;
+            }
+            uint32_t neighbor = index + maze->get_index_offset(side);
+            if (get_cluster(neighbor) != cluster) {
+                continue;
+            }
+            size_t neighbor_local = get_local(neighbor);
+            if (local_stamp[neighbor_local] == local_search) {
+                continue;
+            }
+            local_stamp[neighbor_local] = local_search;
+            local_distance[neighbor_local] = distance + 1;
+            local_parent[neighbor_local] = static_cast<uint8_t>(Maze::get_opposite_side(side));
+            local_queue.push_back(neighbor);
+        }
+    }
+}
+
+uint16_t HPAIndex::get_local_distance(uint32_t index) const {
+    // only called for cells of the cluster that was searched last
+    int first_row = get_cluster(index) / clusters_across * cluster_size;
+    int first_col = get_cluster(index) % clusters_across * cluster_size;
+    size_t local = (index / width - first_row) * cluster_size + (index % width - first_col);
+    return local_stamp[local] == local_search ? local_distance[local] : UNREACHABLE;
+}
+
+void HPAIndex::append_local_path(uint32_t index, Path& path) {
+    int first_row = get_cluster(index) / clusters_across * cluster_size;
+    int first_col = get_cluster(index) % clusters_across * cluster_size;
+    uint32_t target = local_queue[0];
+    while (index != target) {
+        size_t local = (index / width - first_row) * cluster_size + (index % width - first_col);
+        Side side = Side(local_parent[local]);
+        index += maze->get_index_offset(side);
+        path.add_step(Path::Step(side));
+    }
+}
+
+uint32_t HPAIndex::get_node(uint32_t index) const {
+    size_t cluster = get_cluster(index);
+    const vector<uint32_t>& entrances = clusters[cluster].entrances;
+    return cluster * get_slots_per_cluster() + (find(entrances.begin(), entrances.end(), index) - entrances.begin());
+}
+
+void HPAIndex::search_abstract_graph(uint32_t from, vector<uint32_t>& distances) const {
+    size_t slots = get_slots_per_cluster();
+    distances.assign(clusters.size() * slots, UNREACHED);
+    // distance in the high half, node in the low half
+    vector<uint64_t> heap;
+    distances[from] = 0;
+    heap.push_back(from);
+
+    auto relax = [&](uint32_t node, uint32_t distance) {
+        if (distance < distances[node]) {
+            distances[node] = distance;
+            heap.push_back(static_cast<uint64_t>(distance) << 32 | node);
+            push_heap(heap.begin(), heap.end(), greater<uint64_t>());
+        }
+    };
+
+    while (!heap.empty()) {
+        pop_heap(heap.begin(), heap.end(), greater<uint64_t>());
+        uint32_t distance = heap.back() >> 32;
+        uint32_t node = static_cast<uint32_t>(heap.back());
+        heap.pop_back();
+        if (distance != distances[node]) {
+            continue;
+        }
+        const Cluster& c = clusters[node / slots];
+        uint32_t slot = node % slots;
+        for (uint32_t e = c.edge_offsets[slot]; e < c.edge_offsets[slot + 1]; ++e) {
+            relax(node - slot + c.edges[e].slot, distance + c.edges[e].distance);
+        }
+        for (int link = 0; link < 2; ++link) {
+            if (c.links[2 * slot + link] != NO_NODE) {
+                relax(c.links[2 * slot + link], distance + 1);
+            }
+        }
+    }
+}
+
+void HPAIndex::compute_landmarks() {
+    size_t slots = get_slots_per_cluster();
+    size_t slot_count = clusters.size() * slots;
+    landmark_distances.assign(slot_count * LANDMARK_COUNT, UNREACHED);
+
+    uint32_t landmark = NO_NODE;
+    for (size_t cluster = 0; cluster < clusters.size() && landmark == NO_NODE; ++cluster) {
+        if (!clusters[cluster].entrances.empty()) {
+            landmark = cluster * slots;
+        }
+    }
+    if (landmark == NO_NODE) {
+        return;
+    }
+
+    // farthest point selection: the first landmark is the entrance farthest from an arbitrary
+    // one, every next one the entrance farthest from all landmarks so far
+    vector<uint32_t> distances;
+    vector<uint32_t> nearest(slot_count, UNREACHED);
+    search_abstract_graph(landmark, distances);
+    for (int l = -1; l < LANDMARK_COUNT; ++l) {
+        if (l >= 0) {
+            search_abstract_graph(landmark, distances);
+            for (size_t node = 0; node < slot_count; ++node) {
+                landmark_distances[node * LANDMARK_COUNT + l] = distances[node];
+                nearest[node] = min(nearest[node], distances[node]);
+            }
+        }
+        const vector<uint32_t>& spread = l < 0 ? distances : nearest;
+        uint32_t farthest = 0;
+        for (size_t node = 0; node < slot_count; ++node) {
+            if (spread[node] != UNREACHED && spread[node] >= farthest) {
+                farthest = spread[node];
+                landmark = node;
+            }
+        }
+    }
+}
+
+uint32_t HPAIndex::search(uint32_t from, uint32_t to, vector<uint32_t>* nodes) {
+    struct Entry {
+        // distance plus heuristic in the high half, ties go to the larger distance
+        uint64_t key;
+        uint32_t distance;
+        uint32_t node;
+
+        bool operator>(const Entry& other) const {
+            return key > other.key;
+        }
+    };
+
+    if (++abstract_search == 0) {
+        fill(node_stamp.begin(), node_stamp.end(), 0);
+        abstract_search = 1;
+    }
+    size_t slots = get_slots_per_cluster();
+    const uint32_t start_node = node_stamp.size() - 2;
+    const uint32_t goal_node = node_stamp.size() - 1;
+    size_t from_cluster = get_cluster(from);
+    size_t to_cluster = get_cluster(to);
+    int to_row = to / width;
+    int to_col = to % width;
+
+    // the goal connects to the entrances of its cluster, and to from if they share the cluster
+    search_cluster(to);
+    const Cluster& goal_cluster = clusters[to_cluster];
+    vector<uint16_t> goal_distances(goal_cluster.entrances.size());
+    for (size_t i = 0; i < goal_distances.size(); ++i) {
+        goal_distances[i] = get_local_distance(goal_cluster.entrances[i]);
+    }
+    uint16_t direct_distance = from_cluster == to_cluster ? get_local_distance(from) : UNREACHABLE;
+
+    // a path from an entrance to the goal leaves through some entrance e of the goal's cluster,
+    // so for landmark distances a of the node and x of e it is at least
+    // min over e of |a - x| + goal_distance(e) >= max(a - max(x - goal_distance), min(x + goal_distance) - a)
+    int64_t below[LANDMARK_COUNT];
+    int64_t above[LANDMARK_COUNT];
+    bool usable[LANDMARK_COUNT];
+    bool goal_reachable = false;
+    for (int l = 0; l < LANDMARK_COUNT; ++l) {
+        below[l] = INT64_MIN;
+        above[l] = INT64_MAX;
+        usable[l] = true;
+    }
+    for (size_t i = 0; i < goal_distances.size(); ++i) {
+        if (goal_distances[i] == UNREACHABLE) {
+            continue;
+        }
+        goal_reachable = true;
+        const uint32_t* x = &landmark_distances[(to_cluster * slots + i) * LANDMARK_COUNT];
+        for (int l = 0; l < LANDMARK_COUNT; ++l) {
+            usable[l] = usable[l] && x[l] != UNREACHED;
+            below[l] = max<int64_t>(below[l], static_cast<int64_t>(x[l]) - goal_distances[i]);
+            above[l] = min<int64_t>(above[l], static_cast<int64_t>(x[l]) + goal_distances[i]);
+        }
+    }
+
+    auto get_heuristic = [&](uint32_t node, uint32_t cell) {
+        int64_t heuristic = abs(static_cast<int>(cell / width) - to_row) + abs(static_cast<int>(cell % width) - to_col);
+        if (goal_reachable) {
+            const uint32_t* a = &landmark_distances[node * LANDMARK_COUNT];
+            for (int l = 0; l < LANDMARK_COUNT; ++l) {
+                if (usable[l] && a[l] != UNREACHED) {
+                    heuristic = max(heuristic, max(a[l] - below[l], above[l] - a[l]));
+                }
+            }
+        }
+        return static_cast<uint32_t>(heuristic);
+    };
+
+    vector<Entry> heap;
+    auto relax = [&](uint32_t node, uint32_t cell, uint32_t distance, uint32_t parent) {
+        if (node_stamp[node] == abstract_search && node_distance[node] <= distance) {
+            return;
+        }
+        node_stamp[node] = abstract_search;
+        node_distance[node] = distance;
+        node_parent[node] = parent;
+        uint32_t heuristic = node == goal_node ? 0 : get_heuristic(node, cell);
+        heap.push_back({static_cast<uint64_t>(distance + heuristic) << 32 | (UINT32_MAX - distance), distance, node});
+        push_heap(heap.begin(), heap.end(), greater<Entry>());
+    };
+
+    node_stamp[start_node] = abstract_search;
+    node_distance[start_node] = 0;
+    if (direct_distance != UNREACHABLE) {
+        relax(goal_node, to, direct_distance, start_node);
+    }
+    search_cluster(from);
+    const Cluster& start_cluster = clusters[from_cluster];
+    for (size_t i = 0; i < start_cluster.entrances.size(); ++i) {
+        uint16_t distance = get_local_distance(start_cluster.entrances[i]);
+        if (distance != UNREACHABLE) {
+            relax(from_cluster * slots + i, start_cluster.entrances[i], distance, start_node);
+        }
+    }
+
+    while (!heap.empty()) {
+        Entry entry = heap.front();
+        pop_heap(heap.begin(), heap.end(), greater<Entry>());
+        heap.pop_back();
+        if (entry.distance != node_distance[entry.node]) {
+            // a shorter way to the node was found after this entry was queued
+            continue;
+        }
+        if (entry.node == goal_node) {
+            break;
+        }
+
+        size_t cluster = entry.node / slots;
+        uint32_t slot = entry.node % slots;
+        const Cluster& c = clusters[cluster];
+        for (uint32_t e = c.edge_offsets[slot]; e < c.edge_offsets[slot + 1]; ++e) {
+            const Edge& edge = c.edges[e];
+            relax(cluster * slots + edge.slot, c.entrances[edge.slot], entry.distance + edge.distance, entry.node);
+        }
+        for (int link = 0; link < 2; ++link) {
+            uint32_t node = c.links[2 * slot + link];
+            if (node != NO_NODE) {
+                relax(node, clusters[node / slots].entrances[node % slots], entry.distance + 1, entry.node);
+            }
+        }
+        if (cluster == to_cluster && goal_distances[slot] != UNREACHABLE) {
+            relax(goal_node, to, entry.distance + goal_distances[slot], entry.node);
+        }
+    }
+
+    if (node_stamp[goal_node] != abstract_search) {
+        return UNREACHED;
+    }
+    if (nodes) {
+        nodes->clear();
+        nodes->push_back(to);
+        for (uint32_t node = node_parent[goal_node]; node != start_node; node = node_parent[node]) {
+            nodes->push_back(clusters[node / slots].entrances[node % slots]);
+        }
+        nodes->push_back(from);
+        reverse(nodes->begin(), nodes->end());
+    }
+    return node_distance[goal_node];
+}
+
+void HPAIndex::update() {
+    MAZE_PHASE(Phase::INDEX);
+    vector<Maze::WallChange> changes;
+    vector<size_t> changed;
+    if (!maze->get_wall_changes(revision, changes)) {
+        for (size_t cluster = 0; cluster < clusters.size(); ++cluster) {
+            changed.push_back(cluster);
+        }
+        rebuild(changed);
+        compute_landmarks();
+        revision = maze->get_revision();
+        return;
+    }
+
+    // a wall belongs to the cells on both sides, which can be in two clusters
+    bool opened = false;
+    for (const Maze::WallChange& change : changes) {
+        uint32_t index = get_index(make_pair(change.row, change.col));
+        changed.push_back(get_cluster(index));
+        changed.push_back(get_cluster(index + maze->get_index_offset(change.side)));
+        opened = opened || maze->is_passage_open(change.row, change.col, change.side);
+    }
+    sort(changed.begin(), changed.end());
+    changed.erase(unique(changed.begin(), changed.end()), changed.end());
+    rebuild(changed);
+
+    if (opened) {
+        // a shortcut can make landmark distances longer than the real ones
+        compute_landmarks();
+    } else {
+        // still lower bounds, but the rebuilt clusters' entrances moved to other slots
+        size_t slots = get_slots_per_cluster();
+        for (size_t cluster : changed) {
+            fill(landmark_distances.begin() + cluster * slots * LANDMARK_COUNT,
+                landmark_distances.begin() + (cluster + 1) * slots * LANDMARK_COUNT, UNREACHED);
+        }
+    }
+    revision = maze->get_revision();
+}
+
+int64_t HPAIndex::get_distance(pair<int,int> from, pair<int,int> to) {
+    uint32_t distance = search(get_index(from), get_index(to), nullptr);
+    return distance == UNREACHED ? -1 : static_cast<int64_t>(distance);
+}
+
+Path HPAIndex::get_path(pair<int,int> from, pair<int,int> to) {
+    vector<uint32_t> nodes;
+    if (search(get_index(from), get_index(to), &nodes) == UNREACHED) {
+        return Path();
+    }
+
+    Path path(from);
+    for (size_t i = 1; i < nodes.size(); ++i) {
+        if (get_cluster(nodes[i - 1]) != get_cluster(nodes[i])) {
+            // a passage between two clusters
+            path.add(get_cell(nodes[i]));
+            continue;
+        }
+        // inside one cluster, walk the parents of a search from the next node
+        search_cluster(nodes[i], nodes[i - 1]);
+        append_local_path(nodes[i - 1], path);
+    }
+    return path;
+}
+
+size_t HPAIndex::get_entrance_count() const {
+    size_t count = 0;
+    for (const Cluster& cluster : clusters) {
+        count += cluster.entrances.size();
+    }
+    return count;
+}
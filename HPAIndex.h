@@ -0,0 +1,155 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Maze.h"
+#include "Path.h"
+
+/*
+* Hierarchical path-finding (HPA*) index for repeated path queries on mazes with loops, where a
+* TreeIndex doesn't apply.
+*
+* The maze is cut into square clusters. A cell is an entrance when an open passage leads from it
+* into another cluster, and every cluster stores the shortest distances inside the cluster between
+* all of its entrances. Together with the passages between clusters this is a small abstract graph
+* whose distances are the exact maze distances between entrances.
+*
+* A query connects its two cells to the entrances of their clusters with a search bounded to
+* the cluster, runs A* on the abstract graph and refines every abstract edge into cells with
+* another bounded search, so it touches a few clusters' worth of cells plus the abstract nodes
+* in between. Paths are shortest paths.
+*
+* Manhattan distance is a weak A* bound in a maze, so the abstract search also uses landmarks
+* (ALT): the distances from a few far apart entrances to every entrance bound the distance
+* between any two of them by the triangle inequality.
+*
+* After walls change, update() rebuilds only the clusters next to the changed walls. Built walls
+* only make distances longer, which keeps the landmark bounds valid; removed walls also
+* recompute the landmark distances, one Dijkstra over the abstract graph per landmark. The index
+* keeps a pointer to the maze, which must outlive it. Queries reuse scratch memory of the index,
+* so an index is not safe to use from several threads at once.
+*/
+class HPAIndex {
+    static constexpr uint16_t UNREACHABLE = UINT16_MAX;
+
+    static constexpr uint32_t NO_NODE = UINT32_MAX;
+    static constexpr uint32_t UNREACHED = UINT32_MAX;
+    static const int LANDMARK_COUNT = 8;
+
+    // abstract edge between two entrances of a cluster
+    struct Edge {
+        uint16_t slot;
+        uint16_t distance;
+    };
+
+    struct Cluster {
+        // flat indices of the entrance cells
+        std::vector<uint32_t> entrances;
+        // edges of entrance i are edges[edge_offsets[i]] up to edges[edge_offsets[i + 1]]. an edge
+        // is left out when a path through a third entrance is just as short.
+        std::vector<uint32_t> edge_offsets;
+        std::vector<Edge> edges;
+        // two per entrance, the nodes in other clusters that a passage leads to, or NO_NODE
+        std::vector<uint32_t> links;
+    };
+
+    const Maze* maze;
+    int height;
+    int width;
+    int cluster_size;
+    int clusters_across;
+    int clusters_down;
+    uint64_t revision;
+    std::vector<Cluster> clusters;
+
+    // scratch of the bounded searches, one entry per cell of a cluster
+    std::vector<uint32_t> local_stamp;
+    std::vector<uint16_t> local_distance;
+    std::vector<uint8_t> local_parent;
+    std::vector<uint32_t> local_queue;
+    uint32_t local_search;
+
+    // distances over the abstract graph from a few far apart entrances, LANDMARK_COUNT per slot.
+    // UNREACHED where unknown, e.g. for clusters rebuilt since the last refresh
+    std::vector<uint32_t> landmark_distances;
+
+    // scratch of the abstract search, one entry per possible entrance
+    std::vector<uint32_t> node_stamp;
+    std::vector<uint32_t> node_distance;
+    std::vector<uint32_t> node_parent;
+    uint32_t abstract_search;
+
+    size_t get_index(std::pair<int,int> cell) const;
+    std::pair<int,int> get_cell(size_t index) const;
+    size_t get_cluster(uint32_t index) const;
+
+    // number of entrance slots per cluster, one per border cell
+    size_t get_slots_per_cluster() const;
+
+    // finds entrances and the edges between them of one cluster
+    void build_cluster(size_t cluster);
+
+    // finds the links of the entrances of one cluster, its neighbors must be built
+    void link_cluster(size_t cluster);
+
+    // builds the clusters, then links them and their neighbors
+    void rebuild(const std::vector<size_t>& changed);
+
+    /*
+    * Breadth first search from a cell that never leaves its cluster. Afterwards
+    * get_local_distance returns the distance of every cell of the cluster reached.
+    * @param until stops once this cell is reached, UINT32_MAX searches the whole cluster
+    */
+    void search_cluster(uint32_t from, uint32_t until = UINT32_MAX);
+
+    uint16_t get_local_distance(uint32_t index) const;
+
+    // appends the steps from the last search's start to index to the path, which ends at that start
+    void append_local_path(uint32_t index, Path& path);
+
+    // abstract node of an entrance cell, its cluster times get_slots_per_cluster() plus its slot
+    uint32_t get_node(uint32_t index) const;
+
+    /*
+    * Dijkstra over the abstract graph from a node.
+    * @param distances one entry per slot, receives the distance or UNREACHED of every node
+    */
+    void search_abstract_graph(uint32_t from, std::vector<uint32_t>& distances) const;
+
+    // picks the landmarks and computes their distances
+    void compute_landmarks();
+
+    /*
+    * A* over the abstract graph from one cell to another.
+    * @param nodes receives the flat indices of from, the entrances on the way and to
+    * @return the distance, or UINT32_MAX if to can't be reached
+    */
+    uint32_t search(uint32_t from, uint32_t to, std::vector<uint32_t>* nodes);
+
+public:
+    // cells per cluster side unless asked otherwise
+    static const int DEFAULT_CLUSTER_SIZE = 16;
+
+    /*
+    * Builds the index.
+    * Throws std::invalid_argument if the maze or the cluster size is too large.
+    * @param cluster_size cells per cluster side, at most 255
+    */
+    explicit HPAIndex(const Maze& maze, int cluster_size = DEFAULT_CLUSTER_SIZE);
+
+    /*
+    * Rebuilds the clusters next to walls that were edited since the index was built or last
+    * updated, read from the maze's change log. Rebuilds every cluster if the log doesn't reach
+    * back that far.
+    */
+    void update();
+
+    // returns number of steps on a shortest path between the two cells, or -1 if there is none
+    int64_t get_distance(std::pair<int,int> from, std::pair<int,int> to);
+
+    // returns a shortest path between the two cells, or an empty path if there is none
+    Path get_path(std::pair<int,int> from, std::pair<int,int> to);
+
+    // returns total number of entrances, the size of the abstract graph
+    size_t get_entrance_count() const;
+};
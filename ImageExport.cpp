@@ -0,0 +1,341 @@
+#include "ImageExport.h"
+#include <algorithm>
+#include <assert.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+// pixel values, also the PNG palette indices
+static const uint8_t PIXEL_EMPTY = 0;
+static const uint8_t PIXEL_WALL = 1;
+static const uint8_t PIXEL_PATH = 2;
+
+bool parse_image_format(const string& name, ImageFormat& format) {
+    if (name == "pbm") {
+        format = ImageFormat::PBM;
+    } else if (name == "pgm") {
+        format = ImageFormat::PGM;
+    } else if (name == "png") {
+        format = ImageFormat::PNG;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool get_image_format_from_extension(const string& filename, ImageFormat& format) {
+    size_t dot = filename.rfind('.');
+    if (dot == string::npos) {
+        return false;
+    }
+    return parse_image_format(filename.substr(dot + 1), format);
+}
+
+/*
+* Encodes rows of pixel values into one image format.
+*/
+class ImageWriter {
+public:
+    virtual ~ImageWriter() = default;
+
+    // writes one row of width pixel values, rows come top to bottom
+    virtual void write_row(const vector<uint8_t>& pixels) = 0;
+
+    // writes whatever follows the last row
+    virtual void finish() {}
+};
+
+// binary bitmap, 1 bit per pixel with 1 black
+class PBMWriter : public ImageWriter {
+    ostream& out;
+    vector<char> bytes;
+
+public:
+    PBMWriter(ostream& o, uint32_t width, uint32_t height) : out(o), bytes((width + 7) / 8) {
+        out << "P4\n" << width << " " << height << "\n";
+    }
+
+    void write_row(const vector<uint8_t>& pixels) override {
+        fill(bytes.begin(), bytes.end(), 0);
+        for (size_t x = 0; x < pixels.size(); ++x) {
+            if (pixels[x] == PIXEL_WALL) {
+                bytes[x >> 3] |= 0x80 >> (x & 7);
+            }
+        }
+        out.write(bytes.data(), bytes.size());
+    }
+};
+
+// binary graymap, 1 byte per pixel
+class PGMWriter : public ImageWriter {
+    ostream& out;
+    vector<char> bytes;
+
+public:
+    PGMWriter(ostream& o, uint32_t width, uint32_t height) : out(o), bytes(width) {
+        out << "P5\n" << width << " " << height << "\n255\n";
+    }
+
+    void write_row(const vector<uint8_t>& pixels) override {
+        static const char GRAY[] = {char(255), char(0), char(128)};
+        for (size_t x = 0; x < pixels.size(); ++x) {
+            bytes[x] = GRAY[pixels[x]];
+        }
+        out.write(bytes.data(), bytes.size());
+    }
+};
+
+/*
+* PNG with a 3 color palette at 2 bits per pixel. The zlib stream uses stored (uncompressed)
+* deflate blocks, each sent as its own IDAT chunk as soon as it fills, so no compressor is needed
+* and nothing but the current block is buffered.
+*/
+class PNGWriter : public ImageWriter {
+    static const size_t MAX_STORED_BLOCK = 65535;
+
+    ostream& out;
+    vector<uint8_t> scanline;
+    vector<uint8_t> block;
+    uint64_t bytes_left;
+    uint32_t adler_a;
+    uint32_t adler_b;
+    bool zlib_header_written;
+
+    static const uint32_t* get_crc_table() {
+        static uint32_t table[256];
+        static bool initialized = false;
+        if (!initialized) {
+            for (uint32_t n = 0; n < 256; ++n) {
+                uint32_t c = n;
+                for (int k = 0; k < 8; ++k) {
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                }
+                table[n] = c;
+            }
+            initialized = true;
+        }
+        return table;
+    }
+
+    static uint32_t update_crc(uint32_t crc, const uint8_t* data, size_t size) {
+        const uint32_t* table = get_crc_table();
+        for (size_t i = 0; i < size; ++i) {
+            crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        }
+        return crc;
+    }
+
+    static void put_u32(vector<uint8_t>& bytes, uint32_t value) {
+        bytes.push_back(value >> 24);
+        bytes.push_back(value >> 16);
+        bytes.push_back(value >> 8);
+        bytes.push_back(value);
+    }
+
+    void write_chunk(const char* type, const vector<uint8_t>& data) {
+        vector<uint8_t> header;
+        put_u32(header, data.size());
+        header.insert(header.end(), type, type + 4);
+        out.write(reinterpret_cast<const char*>(header.data()), header.size());
+        out.write(reinterpret_cast<const char*>(data.data()), data.size());
+
+        uint32_t crc = update_crc(0xFFFFFFFFu, header.data() + 4, 4);
+        crc = update_crc(crc, data.data(), data.size()) ^ 0xFFFFFFFFu;
+        vector<uint8_t> trailer;
+        put_u32(trailer, crc);
+        out.write(reinterpret_cast<const char*>(trailer.data()), trailer.size());
+    }
+
+    // sends the buffered bytes as one stored block, the last one also ends the zlib stream
+    void flush_block() {
+        bool final_block = bytes_left == 0;
+        vector<uint8_t> data;
+        data.reserve(block.size() + 11);
+        if (!zlib_header_written) {
+            // deflate with a 32K window, no preset dictionary, check bits for 0x7801
+            data.push_back(0x78);
+            data.push_back(0x01);
+            zlib_header_written = true;
+        }
+        uint16_t length = block.size();
+        uint16_t inverse_length = ~length;
+        data.push_back(final_block ? 1 : 0);
+        data.push_back(length & 0xFF);
+        data.push_back(length >> 8);
+        data.push_back(inverse_length & 0xFF);
+        data.push_back(inverse_length >> 8);
+        data.insert(data.end(), block.begin(), block.end());
+        if (final_block) {
+            put_u32(data, (adler_b << 16) | adler_a);
+        }
+        write_chunk("IDAT", data);
+        block.clear();
+    }
+
+    void write_bytes(const uint8_t* bytes, size_t size) {
+        for (size_t i = 0; i < size; ++i) {
+            adler_a = (adler_a + bytes[i]) % 65521;
+            adler_b = (adler_b + adler_a) % 65521;
+            block.push_back(bytes[i]);
+            bytes_left--;
+            if (block.size() == MAX_STORED_BLOCK || bytes_left == 0) {
+                flush_block();
+            }
+        }
+    }
+
+public:
+    PNGWriter(ostream& o, uint32_t width, uint32_t height)
+        : out(o), scanline(1 + (static_cast<size_t>(width) * 2 + 7) / 8),
+          adler_a(1), adler_b(0), zlib_header_written(false) {
+        bytes_left = static_cast<uint64_t>(height) * scanline.size();
+        block.reserve(MAX_STORED_BLOCK);
+
+        static const uint8_t SIGNATURE[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+        out.write(reinterpret_cast<const char*>(SIGNATURE), sizeof(SIGNATURE));
+
+        vector<uint8_t> header;
+        put_u32(header, width);
+        put_u32(header, height);
+        // bit depth 2, palette color, deflate, adaptive filtering, no interlace
+        header.insert(header.end(), {2, 3, 0, 0, 0});
+        write_chunk("IHDR", header);
+
+        // white passages, black walls, red path
+        write_chunk("PLTE", {255, 255, 255, 0, 0, 0, 220, 0, 0});
+    }
+
+    void write_row(const vector<uint8_t>& pixels) override {
+        // filter type 0, then 4 pixels per byte with the leftmost in the high bits
+        fill(scanline.begin(), scanline.end(), 0);
+        for (size_t x = 0; x < pixels.size(); ++x) {
+            scanline[1 + (x >> 2)] |= pixels[x] << (6 - 2 * (x & 3));
+        }
+        write_bytes(scanline.data(), scanline.size());
+    }
+
+    void finish() override {
+        assert(bytes_left == 0);
+        write_chunk("IEND", {});
+    }
+};
+
+/*
+* Path pixels of a band of raw rows, one bit per pixel.
+*/
+class PathBand {
+    size_t words_per_row;
+    int first_row;
+    int row_count;
+    vector<uint64_t> bits;
+
+    void mark(int y, int x) {
+        if (y < first_row || y >= first_row + row_count) {
+            return;
+        }
+        size_t bit = static_cast<size_t>(y - first_row) * words_per_row * 64 + x;
+        bits[bit >> 6] |= uint64_t(1) << (bit & 63);
+    }
+
+public:
+    PathBand(size_t raw_width, int rows) : words_per_row((raw_width + 63) / 64),
+        first_row(0), row_count(rows), bits(words_per_row * rows) {}
+
+    int get_row_count() const {
+        return row_count;
+    }
+
+    // marks the pixels of every path cell and passage that fall in rows [first, first + row_count)
+    void load(const Path& path, int first) {
+        first_row = first;
+        fill(bits.begin(), bits.end(), 0);
+        pair<int,int> previous{-1, -1};
+        for (auto cell : path) {
+            int y = 2 * cell.first + 1;
+            int x = 2 * cell.second + 1;
+            if (previous.first != -1) {
+                mark((y + 2 * previous.first + 1) / 2, (x + 2 * previous.second + 1) / 2);
+            }
+            mark(y, x);
+            previous = cell;
+        }
+    }
+
+    bool is_marked(int y, size_t x) const {
+        size_t bit = static_cast<size_t>(y - first_row) * words_per_row * 64 + x;
+        return (bits[bit >> 6] >> (bit & 63)) & 1;
+    }
+};
+
+void write_maze_image(const Maze& maze, ostream& out, ImageFormat format, size_t band_bytes) {
+    int height = maze.get_height();
+    int width = maze.get_width();
+    int raw_height = 2 * height + 1;
+    size_t raw_width = 2 * static_cast<size_t>(width) + 1;
+
+    unique_ptr<ImageWriter> writer;
+    switch (format) {
+        case ImageFormat::PBM:
+            writer = make_unique<PBMWriter>(out, raw_width, raw_height);
+            break;
+        case ImageFormat::PGM:
+            writer = make_unique<PGMWriter>(out, raw_width, raw_height);
+            break;
+        case ImageFormat::PNG:
+            writer = make_unique<PNGWriter>(out, raw_width, raw_height);
+            break;
+    }
+
+    // PBM can't show the path, so it never needs a band
+    bool has_path = format != ImageFormat::PBM && !maze.get_path().empty();
+    size_t row_bytes = (raw_width + 63) / 64 * sizeof(uint64_t);
+    int band_rows = has_path ? static_cast<int>(min<size_t>(raw_height, max<size_t>(1, band_bytes / row_bytes))) : 0;
+    PathBand band(raw_width, band_rows);
+
+    size_t word_count = (width + 63) / 64;
+    vector<uint64_t> east_walls(word_count);
+    vector<uint64_t> south_walls(word_count);
+    vector<uint8_t> pixels(raw_width);
+
+    for (int y = 0; y < raw_height; ++y) {
+        if (has_path && y % band_rows == 0) {
+            band.load(maze.get_path(), y);
+        }
+
+        if (y == 0) {
+            // top border
+            fill(pixels.begin(), pixels.end(), PIXEL_WALL);
+        } else {
+            // odd rows are cells and their east walls, even rows are south walls and corner posts
+            int row = (y - 1) / 2;
+            if (y % 2 == 1) {
+                maze.get_row_walls(row, east_walls.data(), south_walls.data());
+            }
+            pixels[0] = PIXEL_WALL;
+            for (int col = 0; col < width; ++col) {
+                bool east = (east_walls[col >> 6] >> (col & 63)) & 1;
+                bool south = (south_walls[col >> 6] >> (col & 63)) & 1;
+                size_t x = 2 * static_cast<size_t>(col) + 1;
+                if (y % 2 == 1) {
+                    pixels[x] = PIXEL_EMPTY;
+                    pixels[x + 1] = east ? PIXEL_WALL : PIXEL_EMPTY;
+                } else {
+                    pixels[x] = south ? PIXEL_WALL : PIXEL_EMPTY;
+                    pixels[x + 1] = PIXEL_WALL;
+                }
+            }
+        }
+
+        if (has_path) {
+            for (size_t x = 0; x < raw_width; ++x) {
+                if (band.is_marked(y, x)) {
+                    pixels[x] = PIXEL_PATH;
+                }
+            }
+        }
+        writer->write_row(pixels);
+    }
+    writer->finish();
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include "Maze.h"
+
+/*
+* Streaming bitmap export of a maze and its path.
+*
+* The image is the raw grid, one pixel per get_raw_index coordinate: (2 * height + 1) rows of
+* (2 * width + 1) pixels with walls black, passages white and the path red (PNG) or gray (PGM).
+* PBM has one bit per pixel and shows the walls only.
+*
+* Rows are written top to bottom as they are built, so memory stays at a few rows plus a fixed
+* band of path bits however big the maze is. The path is marked one band of rows at a time,
+* which reads the (compact) Path once per band.
+*/
+enum class ImageFormat { PBM, PGM, PNG };
+
+/*
+* Parses "pbm", "pgm" or "png" into an ImageFormat.
+* @return false if the name is not a known format.
+*/
+bool parse_image_format(const std::string& name, ImageFormat& format);
+
+/*
+* Picks the format from the extension of a file name, e.g. "maze.png".
+* @return false if the extension is not a known format.
+*/
+bool get_image_format_from_extension(const std::string& filename, ImageFormat& format);
+
+/*
+* Writes the maze with its path overlaid as a binary PBM, PGM or PNG image.
+* @param band_bytes memory used for the path bits of one band of rows
+*/
+void write_maze_image(const Maze& maze, std::ostream& out, ImageFormat format, size_t band_bytes = 4 << 20);
@@ -0,0 +1,109 @@
+#include "Instrument.h"
+#include <algorithm>
+
+using namespace std;
+
+static const char* PHASE_NAMES[] = {"generate", "solve", "index"};
+static const char* EVENT_NAMES[] = {"visit", "phase_begin", "phase_end"};
+
+Instrumentation::Instrumentation() {
+    reset();
+}
+
+Instrumentation& Instrumentation::get() {
+    thread_local Instrumentation instrumentation;
+    return instrumentation;
+}
+
+void Instrumentation::reset() {
+    origin = chrono::steady_clock::now();
+    trace_count = 0;
+    current_phase = NO_PHASE;
+    fill(cells_visited, cells_visited + PHASE_COUNT + 1, 0);
+    fill(peak_frontier, peak_frontier + PHASE_COUNT + 1, 0);
+    fill(bytes_allocated, bytes_allocated + PHASE_COUNT + 1, 0);
+    fill(phase_seconds, phase_seconds + PHASE_COUNT, 0.0);
+}
+
+void Instrumentation::enable_trace(size_t capacity) {
+    size_t rounded = 1;
+    while (rounded < capacity) {
+        rounded <<= 1;
+    }
+    trace.assign(capacity == 0 ? 0 : rounded, TraceEvent());
+    trace_count = 0;
+}
+
+void Instrumentation::record(TraceEventType type, uint64_t value) {
+    TraceEvent& event = trace[trace_count & (trace.size() - 1)];
+    event.nanoseconds = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - origin).count();
+    event.value = value;
+    event.type = type;
+    trace_count++;
+}
+
+int Instrumentation::begin_phase(Phase phase) {
+    int previous_phase = current_phase;
+    current_phase = static_cast<int>(phase);
+    if (!trace.empty()) {
+        record(TraceEventType::PHASE_BEGIN, static_cast<uint64_t>(phase));
+    }
+    return previous_phase;
+}
+
+void Instrumentation::end_phase(Phase phase, double seconds, int previous_phase) {
+    // a solver falling back to another one nests the same phase, its time is counted once
+    if (previous_phase != static_cast<int>(phase)) {
+        phase_seconds[static_cast<int>(phase)] += seconds;
+    }
+    current_phase = previous_phase;
+    if (!trace.empty()) {
+        record(TraceEventType::PHASE_END, static_cast<uint64_t>(phase));
+    }
+}
+
+vector<TraceEvent> Instrumentation::get_trace() const {
+    vector<TraceEvent> events;
+    uint64_t first = trace_count - min<uint64_t>(trace_count, trace.size());
+    for (uint64_t i = first; i < trace_count; ++i) {
+        events.push_back(trace[i & (trace.size() - 1)]);
+    }
+    return events;
+}
+
+uint64_t Instrumentation::get_dropped_events() const {
+    return trace_count - min<uint64_t>(trace_count, trace.size());
+}
+
+void Instrumentation::write_counters(ostream& out) const {
+    for (int phase = 0; phase < PHASE_COUNT; ++phase) {
+        const char* name = PHASE_NAMES[phase];
+        out << name << "_seconds " << phase_seconds[phase] << "\n"
+            << name << "_cells_visited " << cells_visited[phase] << "\n"
+            << name << "_peak_frontier " << peak_frontier[phase] << "\n"
+            << name << "_bytes_allocated " << bytes_allocated[phase] << "\n";
+    }
+    out << "trace_events " << min<uint64_t>(trace_count, trace.size()) << "\n"
+        << "trace_dropped " << get_dropped_events() << "\n";
+}
+
+void Instrumentation::write_trace(ostream& out) const {
+    out << "nanoseconds,event,value\n";
+    for (const TraceEvent& event : get_trace()) {
+        out << event.nanoseconds << "," << EVENT_NAMES[static_cast<int>(event.type)] << ",";
+        if (event.type == TraceEventType::VISIT) {
+            out << event.value << "\n";
+        } else {
+            out << PHASE_NAMES[event.value] << "\n";
+        }
+    }
+}
+
+PhaseTimer::PhaseTimer(Phase p) : phase(p), start(chrono::steady_clock::now()) {
+    previous_phase = Instrumentation::get().begin_phase(phase);
+}
+
+PhaseTimer::~PhaseTimer() {
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    Instrumentation::get().end_phase(phase, seconds, previous_phase);
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+/*
+* Counters and an optional event trace for generators and solvers.
+*
+* Code is instrumented through the MAZE_* macros at the bottom of this file. They only do
+* something when the build defines MAZE_INSTRUMENT (g++ -DMAZE_INSTRUMENT ...), otherwise they
+* expand to nothing and instrumented code compiles to exactly what it was without them.
+*
+* Every thread has its own Instrumentation, so parallel solves never share counters. Workers of
+* the parallel solvers don't count, their caller counts on their behalf.
+*
+* Counts go to the innermost phase scope (MAZE_PHASE) that is open. Counts made outside every
+* phase scope, e.g. path queries on an index, are dropped.
+*/
+enum class Phase { GENERATE, SOLVE, INDEX };
+
+enum class TraceEventType : uint8_t { VISIT, PHASE_BEGIN, PHASE_END };
+
+struct TraceEvent {
+    // time since the instrumentation was last reset
+    uint64_t nanoseconds;
+    // flat cell index (row * width + col) of a VISIT, the Phase of PHASE_BEGIN and PHASE_END
+    uint64_t value;
+    TraceEventType type;
+};
+
+class Instrumentation {
+    std::chrono::steady_clock::time_point origin;
+    std::vector<TraceEvent> trace;
+    uint64_t trace_count;
+    // counters go to the innermost open phase, NO_PHASE outside of them
+    int current_phase;
+
+    void record(TraceEventType type, uint64_t value);
+
+public:
+    static const int PHASE_COUNT = 3;
+    // slot of the counts made outside every phase, which are never reported
+    static const int NO_PHASE = PHASE_COUNT;
+
+    // counters per Phase
+    uint64_t cells_visited[PHASE_COUNT + 1];
+    size_t peak_frontier[PHASE_COUNT + 1];
+    size_t bytes_allocated[PHASE_COUNT + 1];
+    double phase_seconds[PHASE_COUNT];
+
+    Instrumentation();
+
+    // returns the instrumentation of the calling thread
+    static Instrumentation& get();
+
+    // zeroes every counter, clears the trace and restarts the trace clock
+    void reset();
+
+    /*
+    * Keeps the last events in a ring buffer, older events are overwritten.
+    * @param capacity number of events kept, rounded up to a power of two, 0 turns tracing off
+    */
+    void enable_trace(size_t capacity);
+
+    // counts a cell being visited and traces it
+    void count_visit(uint64_t cell) {
+        cells_visited[current_phase]++;
+        if (!trace.empty()) {
+            record(TraceEventType::VISIT, cell);
+        }
+    }
+
+    // keeps the largest frontier (or stack) size seen
+    void track_frontier(size_t size) {
+        if (size > peak_frontier[current_phase]) {
+            peak_frontier[current_phase] = size;
+        }
+    }
+
+    void count_allocation(size_t bytes) {
+        bytes_allocated[current_phase] += bytes;
+    }
+
+    /*
+    * Sends the counters to the phase until end_phase.
+    * @return the phase counted before, to pass to end_phase
+    */
+    int begin_phase(Phase phase);
+
+    /*
+    * Adds the seconds to the phase, unless it was already open around this scope, and sends the
+    * counters back to the previous phase.
+    */
+    void end_phase(Phase phase, double seconds, int previous_phase);
+
+    // returns the traced events, oldest first
+    std::vector<TraceEvent> get_trace() const;
+
+    // returns number of events that were overwritten in the ring buffer
+    uint64_t get_dropped_events() const;
+
+    // writes the counters as "phase_name value" lines
+    void write_counters(std::ostream& out) const;
+
+    // writes the trace as CSV lines of nanoseconds,event,value
+    void write_trace(std::ostream& out) const;
+};
+
+/*
+* Adds the wall time of its scope to a phase, and counts in that phase until the scope ends.
+*/
+class PhaseTimer {
+    Phase phase;
+    int previous_phase;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    explicit PhaseTimer(Phase phase);
+    ~PhaseTimer();
+};
+
+#ifdef MAZE_INSTRUMENT
+#define MAZE_COUNT_VISIT(cell) Instrumentation::get().count_visit(cell)
+#define MAZE_TRACK_FRONTIER(size) Instrumentation::get().track_frontier(size)
+#define MAZE_COUNT_ALLOCATION(bytes) Instrumentation::get().count_allocation(bytes)
+#define MAZE_PHASE(phase) PhaseTimer maze_phase_timer(phase)
+#else
+#define MAZE_COUNT_VISIT(cell) ((void)0)
+#define MAZE_TRACK_FRONTIER(size) ((void)0)
+#define MAZE_COUNT_ALLOCATION(bytes) ((void)0)
+#define MAZE_PHASE(phase) ((void)0)
+#endif
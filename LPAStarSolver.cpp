@@ -0,0 +1,214 @@
+#include "LPAStarSolver.h"
+#include "Instrument.h"
+#include "VisitQueue.h"
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+
+using namespace std;
+
+using Side = Maze::Side;
+
+static const Side SIDES[] = {Side::TOP, Side::RIGHT, Side::BOTTOM, Side::LEFT};
+
+LPAStarSolver::LPAStarSolver()
+    : maze(nullptr), maze_id(0), height(0), width(0), start_index(0), end_index(0), revision(0) {}
+
+string LPAStarSolver::get_name() const {
+    return "lpastar";
+}
+
+void LPAStarSolver::reset(const Maze& m, pair<int,int> start, pair<int,int> end) {
+    size_t cell_count = static_cast<size_t>(m.get_height()) * m.get_width();
+    if (cell_count >= INFINITE) {
+        throw invalid_argument("Maze is too large for the incremental solver");
+    }
+    maze = &m;
+    maze_id = m.get_id();
+    height = m.get_height();
+    width = m.get_width();
+    start_index = get_index(m, start);
+    end_index = get_index(m, end);
+
+    g.assign(cell_count, INFINITE);
+    rhs.assign(cell_count, INFINITE);
+    queue_position.assign(cell_count, NOT_QUEUED);
+    queue.clear();
+    MAZE_COUNT_ALLOCATION(cell_count * 3 * sizeof(uint32_t));
+
+    rhs[start_index] = 0;
+    queue_push(start_index, get_key(start_index));
+}
+
+uint64_t LPAStarSolver::get_key(uint32_t index) const {
+    uint32_t distance = min(g[index], rhs[index]);
+    if (distance == INFINITE) {
+        return UINT64_MAX;
+    }
+    int row = index / width;
+    int col = index % width;
+    uint32_t heuristic = abs(row - static_cast<int>(end_index / width)) + abs(col - static_cast<int>(end_index % width));
+    return (static_cast<uint64_t>(distance) + heuristic) << 32 | distance;
+}
+
+void LPAStarSolver::place(uint32_t slot, QueueEntry entry) {
+    queue[slot] = entry;
+    queue_position[entry.index] = slot;
+}
+
+void LPAStarSolver::sift_up(uint32_t slot) {
+    QueueEntry entry = queue[slot];
+    while (slot > 0) {
+        uint32_t parent = (slot - 1) / 2;
+        if (queue[parent].key <= entry.key) {
+            break;
+        }
+        place(slot, queue[parent]);
+        slot = parent;
+    }
+    place(slot, entry);
+}
+
+void LPAStarSolver::sift_down(uint32_t slot) {
+    QueueEntry entry = queue[slot];
+    uint32_t size = queue.size();
+    while (true) {
+        uint32_t child = 2 * slot + 1;
+        if (child >= size) {
+            break;
+        }
+        if (child + 1 < size && queue[child + 1].key < queue[child].key) {
+            child++;
+        }
+        if (entry.key <= queue[child].key) {
+            break;
+        }
+        place(slot, queue[child]);
+        slot = child;
+    }
+    place(slot, entry);
+}
+
+void LPAStarSolver::queue_push(uint32_t index, uint64_t key) {
+    queue.push_back({key, index});
+    sift_up(queue.size() - 1);
+}
+
+void LPAStarSolver::queue_remove(uint32_t index) {
+    uint32_t slot = queue_position[index];
+    queue_position[index] = NOT_QUEUED;
+    QueueEntry last = queue.back();
+    queue.pop_back();
+    if (slot == queue.size()) {
+        return;
+    }
+    // the last entry fills the hole and moves whichever way its key needs
+    place(slot, last);
+    sift_up(slot);
+    sift_down(queue_position[last.index]);
+}
+
+void LPAStarSolver::queue_pop() {
+    queue_remove(queue[0].index);
+}
+
+void LPAStarSolver::update_cell(uint32_t index) {
+    if (index != start_index) {
+        int row = index / width;
+        int col = index % width;
+        uint32_t best = INFINITE;
+        for (Side side : SIDES) {
+            if (!maze->is_passage_open(row, col, side)) {
+                continue;
+            }
+            uint32_t neighbor_g = g[index + maze->get_index_offset(side)];
+            if (neighbor_g != INFINITE) {
+                best = min(best, neighbor_g + 1);
+            }
+        }
+        rhs[index] = best;
+    }
+
+    if (queue_position[index] != NOT_QUEUED) {
+        queue_remove(index);
+    }
+    if (g[index] != rhs[index]) {
+        queue_push(index, get_key(index));
+    }
+}
+
+void LPAStarSolver::compute_shortest_path() {
+    while (!queue.empty() && (queue[0].key < get_key(end_index) || rhs[end_index] != g[end_index])) {
+        uint32_t index = queue[0].index;
+        queue_pop();
+        nodes_expanded++;
+        MAZE_COUNT_VISIT(index);
+        publish_visit(index);
+
+        if (g[index] > rhs[index]) {
+            // overconsistent: the cell got closer, settle it
+            g[index] = rhs[index];
+        } else {
+            // underconsistent: the cell got farther, forget it and let the neighbors re-derive it
+            g[index] = INFINITE;
+            update_cell(index);
+        }
+
+        int row = index / width;
+        int col = index % width;
+        for (Side side : SIDES) {
+            if (maze->is_passage_open(row, col, side)) {
+                update_cell(index + maze->get_index_offset(side));
+            }
+        }
+        MAZE_TRACK_FRONTIER(queue.size());
+    }
+}
+
+Path LPAStarSolver::solve(const Maze& m, pair<int,int> start, pair<int,int> end) {
+    MAZE_PHASE(Phase::SOLVE);
+    nodes_expanded = 0;
+
+    changes.clear();
+    bool same_search = maze_id == m.get_id() && height == m.get_height() && width == m.get_width()
+        && start_index == get_index(m, start) && end_index == get_index(m, end)
+        && m.get_wall_changes(revision, changes);
+
+    if (!same_search) {
+        reset(m, start, end);
+    } else {
+        maze = &m;
+        // a wall between two cells only changes what those two cells can derive
+        for (const Maze::WallChange& change : changes) {
+            uint32_t index = get_index(m, make_pair(change.row, change.col));
+            update_cell(index);
+            update_cell(index + m.get_index_offset(change.side));
+        }
+    }
+    revision = m.get_revision();
+
+    compute_shortest_path();
+    if (g[end_index] == INFINITE) {
+        return Path();
+    }
+
+    // walk back from the end, every step goes to a neighbor one closer to the start
+    Path path(end);
+    uint32_t index = end_index;
+    while (index != start_index) {
+        pair<int,int> cell = get_cell(m, index);
+        for (Side side : SIDES) {
+            if (!m.is_passage_open(cell.first, cell.second, side)) {
+                continue;
+            }
+            uint32_t neighbor = index + m.get_index_offset(side);
+            if (g[neighbor] != INFINITE && g[neighbor] + 1 == g[index]) {
+                index = neighbor;
+                path.add_step(Path::Step(side));
+                break;
+            }
+        }
+    }
+    path.reverse();
+    return path;
+}
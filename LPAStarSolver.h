@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Solver.h"
+
+/*
+* Lifelong Planning A*: an A* that keeps its search state between solves and, after walls were
+* built or removed, only repairs the cells whose distance from the start actually changed.
+*
+* Every cell has g, its distance from the start as last expanded, and rhs, the distance its
+* neighbors' g values imply. Cells where the two differ are queued by A* keys and expanded
+* until the end cell is consistent. A wall edit only makes the two cells next to it
+* inconsistent, so a re-solve does work in proportion to the region whose distances changed
+* rather than the maze.
+*
+* The state belongs to the last maze (by Maze::get_id), start and end that were solved. The wall edits since then
+* are read from the maze's change log (Maze::get_wall_changes). A different maze, start or end,
+* or more edits than the log holds, starts a fresh search.
+*/
+class LPAStarSolver : public Solver {
+    static constexpr uint32_t INFINITE = UINT32_MAX;
+    static constexpr uint32_t NOT_QUEUED = UINT32_MAX;
+
+    struct QueueEntry {
+        uint64_t key;
+        uint32_t index;
+    };
+
+    const Maze* maze;
+    uint64_t maze_id;
+    int height;
+    int width;
+    uint32_t start_index;
+    uint32_t end_index;
+    uint64_t revision;
+
+    std::vector<uint32_t> g;
+    std::vector<uint32_t> rhs;
+    // binary min-heap on key, queue_position holds the heap slot of every queued cell
+    std::vector<QueueEntry> queue;
+    std::vector<uint32_t> queue_position;
+    std::vector<Maze::WallChange> changes;
+
+    // starts a fresh search on the maze
+    void reset(const Maze& maze, std::pair<int,int> start, std::pair<int,int> end);
+
+    // A* key of a cell, (min(g, rhs) + heuristic, min(g, rhs)) packed into one integer
+    uint64_t get_key(uint32_t index) const;
+
+    void queue_push(uint32_t index, uint64_t key);
+    void queue_remove(uint32_t index);
+    void queue_pop();
+    void sift_up(uint32_t slot);
+    void sift_down(uint32_t slot);
+    void place(uint32_t slot, QueueEntry entry);
+
+    // recomputes rhs of a cell from its open neighbors and queues it if it is inconsistent
+    void update_cell(uint32_t index);
+
+    // expands inconsistent cells until the end cell is consistent
+    void compute_shortest_path();
+
+public:
+    LPAStarSolver();
+
+    std::string get_name() const override;
+    Path solve(const Maze& maze, std::pair<int,int> start, std::pair<int,int> end) override;
+};
@@ -1,19 +1,21 @@
 #include "Maze.h"
 #include <iostream>
+#include <fstream>
+#include <stdexcept>
 #include <vector>
 #include <stack>
 #include <algorithm>
-#include <map>
+#include <atomic>
 #include <assert.h>
-#include <time.h>
-#include <ncurses.h>
 #include "Path.h"
-
-#ifdef _WIN32
-#include <Windows.h>
-#else
-#include <unistd.h>
-#endif
+#include "SolverWorkspace.h"
+#include "Solver.h"
+#include "DisjointSet.h"
+#include "EllerGenerator.h"
+#include "MazeFile.h"
+#include "MazeRenderer.h"
+#include "Instrument.h"
+#include "MazeAlgorithms.h"
 
 /**
  *  0 1
@@ -33,6 +35,10 @@
  * - bottom = 6 + raw_width = 11
  * If first cell calculation is accurate, left, right, bottom, top will always be ok.
  * to check if first cell calculation is ok, raw_row must be odd and row_col must be odd.
+ *
+ * The raw grid is only a view, it is not stored. WallGrid keeps the right and bottom wall
+ * of each cell, so raw (odd, even) maps to the right wall of cell (y / 2, x / 2 - 1)
+ * and raw (even, odd) to the bottom wall of cell (y / 2 - 1, x / 2).
 */
 
 using namespace std;
@@ -52,30 +58,56 @@ bool Maze::is_row_col_ok(int row, int col) {
 
 Maze::GridValue Maze::get_cell(int row, int col) {
     assert_row_col(row, col);
-    return grid[get_raw_index(width) * get_raw_index(row) + get_raw_index(col)];
+    return grid.is_on_path(row, col, WallGrid::PATH_CELL) ? GridValue::PATH : GridValue::EMPTY;
 }
 
 void Maze::set_cell(int row, int col, GridValue value) {
     assert_row_col(row, col);
-    grid[get_raw_index(width) * get_raw_index(row) + get_raw_index(col)] = value;
+    assert(value != GridValue::WALL);
+    grid.set_on_path(row, col, WallGrid::PATH_CELL, value == GridValue::PATH);
+}
+
+Maze::GridValue Maze::get_stored_wall(int row, int col, bool east) {
+    bool built = east ? grid.has_east_wall(row, col) : grid.has_south_wall(row, col);
+    if (built) {
+        return GridValue::WALL;
+    }
+    int plane = east ? WallGrid::PATH_EAST : WallGrid::PATH_SOUTH;
+    return grid.is_on_path(row, col, plane) ? GridValue::PATH : GridValue::EMPTY;
+}
+
+void Maze::set_stored_wall(int row, int col, bool east, GridValue value) {
+    bool built = value == GridValue::WALL;
+    if (east) {
+        grid.set_east_wall(row, col, built);
+        grid.set_on_path(row, col, WallGrid::PATH_EAST, value == GridValue::PATH);
+    } else {
+        grid.set_south_wall(row, col, built);
+        grid.set_on_path(row, col, WallGrid::PATH_SOUTH, value == GridValue::PATH);
+    }
 }
 
 void Maze::set_wall_value(int row, int col, std::vector<Side> walls, GridValue value) {
     assert_row_col(row, col);
-    int cell_index = get_raw_index(width) * get_raw_index(row) + get_raw_index(col);
     for (auto wall : walls) {
         switch(wall) {
             case Side::TOP:
-                set_grid_index_if_valid(cell_index - get_raw_index(width), value);
+                // top border is fixed
+                if (row > 0) {
+                    set_stored_wall(row - 1, col, false, value);
+                }
                 break;
             case Side::BOTTOM:
-                set_grid_index_if_valid(cell_index + get_raw_index(width), value);
+                set_stored_wall(row, col, false, value);
                 break;
             case Side::LEFT:
-                set_grid_index_if_valid(cell_index - 1, value);
+                // left border is fixed
+                if (col > 0) {
+                    set_stored_wall(row, col - 1, true, value);
+                }
                 break;
             case Side::RIGHT:
-                set_grid_index_if_valid(cell_index + 1, value);
+                set_stored_wall(row, col, true, value);
                 break;
             default:
                 throw;
@@ -88,17 +120,13 @@ Maze::GridValue Maze::get_wall_value(int row, int col, Side wall) {
     assert_row_col(row, col);
     switch(wall) {
         case Side::TOP:
-            return get_raw(get_raw_index(row) - 1, get_raw_index(col));
-            break;
+            return row == 0 ? GridValue::WALL : get_stored_wall(row - 1, col, false);
         case Side::BOTTOM:
-            return get_raw(get_raw_index(row) + 1, get_raw_index(col));
-            break;
+            return get_stored_wall(row, col, false);
         case Side::LEFT:
-             return get_raw(get_raw_index(row), get_raw_index(col) - 1);
-            break;
+            return col == 0 ? GridValue::WALL : get_stored_wall(row, col - 1, true);
         case Side::RIGHT:
-             return get_raw(get_raw_index(row), get_raw_index(col) + 1);
-            break;
+            return get_stored_wall(row, col, true);
         default:
             throw;
     }
@@ -118,7 +146,19 @@ Maze::GridValue Maze::get_raw(int y, int x) {
     assert(x >= 0);
     assert(x < get_raw_index(width));
 
-    return grid[get_raw_index(width) * y + x];
+    // corner posts and top/left borders
+    if ((y % 2 == 0 && x % 2 == 0) || y == 0 || x == 0) {
+        return GridValue::WALL;
+    }
+    if (y % 2 == 1 && x % 2 == 1) {
+        return get_cell(y / 2, x / 2);
+    }
+    if (y % 2 == 1) {
+        // wall east of the cell to its left
+        return get_stored_wall(y / 2, x / 2 - 1, true);
+    }
+    // wall south of the cell above it
+    return get_stored_wall(y / 2 - 1, x / 2, false);
 }
 
 void Maze::set_raw(int y, int x, GridValue value) {
@@ -127,55 +167,42 @@ void Maze::set_raw(int y, int x, GridValue value) {
     assert(x >= 0);
     assert(x < get_raw_index(width));
 
-    grid[get_raw_index(width) * y + x] = value;
+    if ((y % 2 == 0 && x % 2 == 0) || y == 0 || x == 0) {
+        return;
+    }
+    if (y % 2 == 1 && x % 2 == 1) {
+        set_cell(y / 2, x / 2, value);
+    } else if (y % 2 == 1) {
+        set_stored_wall(y / 2, x / 2 - 1, true, value);
+    } else {
+        set_stored_wall(y / 2 - 1, x / 2, false, value);
+    }
 }
 
 void Maze::set_grid_index_if_valid(int index, GridValue value) {
     if (index < 0 || index >= get_raw_index(width) * get_raw_index(height)) {
         return;
     }
-    grid[index] = value;
+    set_raw(index / get_raw_index(width), index % get_raw_index(width), value);
 }
 
 void Maze::fill_borders() {
-    vector<int> ys_to_set;
-
-    for (int y = 0; y < get_raw_index(height); y += 2) {
-        ys_to_set.push_back(y);
-    }
-
-    vector<int> xs_to_set;
-
-    for (int x = 0; x < get_raw_index(width); x += 2) {
-        xs_to_set.push_back(x);
-    }
-
-    for (auto y : ys_to_set) {
-        for (int x = 0; x < get_raw_index(width); ++x) {
-            set_raw(y,x,GridValue::WALL);
-        }
-    }
-
-    for (auto x : xs_to_set) {
-        for (int y = 0; y < get_raw_index(height); ++y) {
-            set_raw(y,x,GridValue::WALL);
-        }
-    }
+    grid.fill_walls();
 }
 
 pair<int,int> Maze::get_random_coordinate_based_on_side(Side side) {
     switch(side) {
         case Side::TOP:
-            return make_pair(0, rand() % width);
+            return make_pair(0, random.next_below(width));
             break;
         case Side::LEFT:
-            return make_pair(rand() % height, 0);
+            return make_pair(random.next_below(height), 0);
             break;
         case Side::BOTTOM:
-            return make_pair(height - 1, rand() % width);
+            return make_pair(height - 1, random.next_below(width));
             break;
         case Side::RIGHT:
-            return make_pair(rand() % height, width - 1);
+            return make_pair(random.next_below(height), width - 1);
             break;
         default:
             throw;
@@ -223,6 +250,7 @@ void Maze::create_maze_randomized_dfs() {
     // choose initial cell, mark as visited and push to stack
     visited[0][0] = true;
     s.push(make_pair(0,0));
+    MAZE_COUNT_VISIT(0);
 
     while (!s.empty()) {
         // while stack is not empty, pop
@@ -247,7 +275,7 @@ void Maze::create_maze_randomized_dfs() {
             continue;
         }
 
-        pair<int,int> random_unvisited_neighbor = unvisited_neighbors[rand() % unvisited_neighbors.size()];
+        pair<int,int> random_unvisited_neighbor = unvisited_neighbors[random.next_below(unvisited_neighbors.size())];
 
         pair<int,int> diff = make_pair(
             random_unvisited_neighbor.first - current_cell.first,
@@ -286,108 +314,494 @@ void Maze::create_maze_randomized_dfs() {
             throw;
         }
 
-        map<Side, string> side_to_str_mapping{
-            {Side::TOP, "top"},
-            {Side::BOTTOM, "bottom"},
-            {Side::LEFT, "left"},
-            {Side::RIGHT, "right"}
-        };
-
         remove_wall(current_cell.first, current_cell.second, {to_remove});
+        if (!tree_parents.empty()) {
+            set_tree_parent(static_cast<size_t>(random_unvisited_neighbor.first) * width + random_unvisited_neighbor.second,
+                get_opposite_side(to_remove));
+        }
 
         // mark that neighbor as visited and push to stack
         visited[random_unvisited_neighbor.first][random_unvisited_neighbor.second] = true;
         s.push(random_unvisited_neighbor);
         history.push(current_cell);
+        MAZE_COUNT_VISIT(static_cast<size_t>(random_unvisited_neighbor.first) * width + random_unvisited_neighbor.second);
+        MAZE_TRACK_FRONTIER(s.size() + history.size());
     }
+}
 
-    start_location = make_pair(0,0);
-    end_location = make_pair(height - 1, width - 1);
+void Maze::open_passage(int row, int col, Side side) {
+    set_wall(row, col, side, false);
 }
 
-int Maze::get_raw_index(int s) {
-    return s * 2 + 1;
+void Maze::set_wall(int row, int col, Side side, bool built) {
+    switch(side) {
+        case Side::TOP:
+            grid.set_south_wall(row - 1, col, built);
+            break;
+        case Side::BOTTOM:
+            grid.set_south_wall(row, col, built);
+            break;
+        case Side::LEFT:
+            grid.set_east_wall(row, col - 1, built);
+            break;
+        case Side::RIGHT:
+            grid.set_east_wall(row, col, built);
+            break;
+        default:
+            throw;
+    }
+    record_wall_change(row, col, side);
 }
 
-void Maze::initialize_random_maze() {
-    fill_borders();
-    create_maze_randomized_dfs();
+void Maze::braid(double fraction) {
+    // compare 53 random bits against the fraction, like a uniform double in [0, 1)
+    const uint64_t threshold = static_cast<uint64_t>(fraction * (uint64_t(1) << 53));
+    for (int row = 0; row < height; ++row) {
+        for (int col = 0; col < width; ++col) {
+            if (col < width - 1 && grid.has_east_wall(row, col) && (random.next() >> 11) < threshold) {
+                set_wall(row, col, Side::RIGHT, false);
+            }
+            if (row < height - 1 && grid.has_south_wall(row, col) && (random.next() >> 11) < threshold) {
+                set_wall(row, col, Side::BOTTOM, false);
+            }
+        }
+    }
 }
 
-void Maze::display_maze() {
+void Maze::record_wall_change(int row, int col, Side side) {
+    if (!logging_wall_changes) {
+        return;
+    }
+    if (wall_changes.empty()) {
+        wall_changes.resize(WALL_CHANGE_LOG_SIZE);
+    }
+    wall_changes[revision % WALL_CHANGE_LOG_SIZE] = WallChange{row, col, side};
+    revision++;
+}
 
-    cout << "Displaying maze with ncurses of height : " << height << " and width : " << width << endl;
-    initscr();
-    move(0,0);
-    printw("Displaying maze with ncurses.\n");	/* Print Hello World		  */
-    refresh();
-    noecho();
-    cbreak();
-    start_color();
-    init_pair(1, COLOR_RED, COLOR_BLUE);
-    for (int row = 0; row < get_raw_index(height); ++row) {
-        for (int col = 0; col < get_raw_index(width); ++col) {
-            if (get_raw(row, col) == GridValue::WALL) {
-                addch(ACS_BLOCK);
-                // cout << "\u25A0";
-            } else if (get_raw(row, col) == GridValue::PATH) {
-                addch(ACS_BLOCK | COLOR_PAIR(1));
-                // printw("\033[1;31m\u25A0\033[0m");
-                // cout << "\033[1;31m\u25A0\033[0m";
-            } else if (get_raw(row, col) == GridValue::EMPTY) {
-                printw(" ");
-                // cout << " ";
-            } else {
-                throw;
+uint64_t Maze::get_revision() const {
+    return revision;
+}
+
+uint64_t Maze::get_id() const {
+    return identity.get();
+}
+
+uint64_t Maze::get_wall_hash() const {
+    // FNV-1a over whole words, then a final mix so nearby mazes spread over all bits
+    uint64_t hash = 14695981039346656037ULL ^ (static_cast<uint64_t>(height) << 32 | static_cast<uint32_t>(width));
+    WallGrid scratch;
+    const uint64_t* words = get_row_major_walls(scratch);
+    size_t word_count = WallGrid::get_wall_word_count(height, width);
+    for (size_t i = 0; i < word_count; ++i) {
+        hash = (hash ^ words[i]) * 1099511628211ULL;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+bool Maze::has_spanning_tree() const {
+    // generation ends at revision 0, any edit since may have broken the tree
+    return !tree_parents.empty() && revision == 0;
+}
+
+Maze::Side Maze::get_tree_parent(size_t index) const {
+    return Side((tree_parents[index / 32] >> (2 * (index % 32))) & 3);
+}
+
+void Maze::set_tree_parent(size_t index, Side side) {
+    int shift = 2 * (index % 32);
+    uint64_t& word = tree_parents[index / 32];
+    word = (word & ~(uint64_t(3) << shift)) | static_cast<uint64_t>(side) << shift;
+}
+
+void Maze::root_tree_at_origin(size_t old_root) {
+    // reverses the parents on the way from (0,0) up to the old root, the rest keeps its parents
+    size_t index = 0;
+    Side towards_previous = Side::TOP;
+    while (index != old_root) {
+        Side side = get_tree_parent(index);
+        if (index != 0) {
+            set_tree_parent(index, towards_previous);
+        }
+        towards_previous = get_opposite_side(side);
+        index += get_index_offset(side);
+    }
+    if (old_root != 0) {
+        set_tree_parent(old_root, towards_previous);
+    }
+}
+
+void Maze::record_tree_by_walk() {
+    // in a tree every open side of a cell except the one to its parent leads to a child,
+    // so the walk needs no visited marks
+    const Side sides[] = {Side::TOP, Side::RIGHT, Side::BOTTOM, Side::LEFT};
+    vector<size_t> stack{0};
+    while (!stack.empty()) {
+        size_t index = stack.back();
+        stack.pop_back();
+        int row = index / width;
+        int col = index % width;
+        for (Side side : sides) {
+            if (!is_passage_open(row, col, side) || (index != 0 && side == get_tree_parent(index))) {
+                continue;
             }
+            size_t child = index + get_index_offset(side);
+            set_tree_parent(child, get_opposite_side(side));
+            stack.push_back(child);
         }
-        printw("\n");
-        // cout << endl;
+        MAZE_TRACK_FRONTIER(stack.size());
     }
-    refresh();
-    getch();
+}
 
-    // now print Path object one by one
+Path Maze::get_tree_path(pair<int,int> cell) const {
+    assert(has_spanning_tree());
+    // walks up to the root and turns the steps around
+    Path path(cell);
+    size_t index = static_cast<size_t>(cell.first) * width + cell.second;
+    while (index != 0) {
+        Side side = get_tree_parent(index);
+        path.add_step(Path::Step(side));
+        index += get_index_offset(side);
+    }
+    path.reverse();
+    return path;
+}
 
-    vector<pair<int,int>> path_to_print = path.get_path_coordinates();
+static atomic<uint64_t> next_maze_id(1);
 
-    pair<int,int> prev{-1,-1};
+Maze::Identity::Identity() : value(next_maze_id++) {}
 
-    pair<int,int> offset{1,0};
+Maze::Identity::Identity(const Identity&) : Identity() {}
 
-    int time_between_path_cells_us = 700;
+Maze::Identity& Maze::Identity::operator=(const Identity&) {
+    value = next_maze_id++;
+    return *this;
+}
+
+uint64_t Maze::Identity::get() const {
+    return value;
+}
+
+bool Maze::get_wall_changes(uint64_t since_revision, vector<WallChange>& changes) const {
+    assert(since_revision <= revision);
+    if (revision - since_revision > WALL_CHANGE_LOG_SIZE) {
+        return false;
+    }
+    for (uint64_t r = since_revision; r < revision; ++r) {
+        changes.push_back(wall_changes[r % WALL_CHANGE_LOG_SIZE]);
+    }
+    return true;
+}
 
-    for (auto cell : path_to_print) {
-        if (prev.first != -1) {
-            pair<int,int> wall = get_wall_raw_coordinates(prev, cell);
-            move(offset.first + wall.first, offset.second + wall.second);
-            addch(ACS_BLOCK | COLOR_PAIR(1));
-            refresh();
-            usleep(time_between_path_cells_us);
+bool Maze::has_neighbor(int row, int col, Side side) const {
+    switch(side) {
+        case Side::TOP:
+            return row > 0;
+        case Side::BOTTOM:
+            return row < height - 1;
+        case Side::LEFT:
+            return col > 0;
+        case Side::RIGHT:
+            return col < width - 1;
+        default:
+            throw;
+    }
+}
+
+void Maze::create_maze_kruskal() {
+    // every inner wall as (cell index << 1) | is_south, removed in random order
+    // whenever it separates two cells that are not connected yet
+    size_t cell_count = static_cast<size_t>(width) * height;
+    assert(cell_count <= UINT32_MAX / 2);
+
+    vector<uint32_t> edges;
+    edges.reserve(2 * cell_count);
+    MAZE_COUNT_ALLOCATION(2 * cell_count * sizeof(uint32_t));
+    for (int row = 0; row < height; ++row) {
+        for (int col = 0; col < width; ++col) {
+            uint32_t index = row * width + col;
+            if (col < width - 1) {
+                edges.push_back(index << 1);
+            }
+            if (row < height - 1) {
+                edges.push_back((index << 1) | 1);
+            }
         }
-        prev = cell;
+    }
 
-        move(offset.first + get_raw_index(cell.first), offset.second + get_raw_index(cell.second));
-        addch(ACS_BLOCK | COLOR_PAIR(1));
-        refresh();
-        usleep(time_between_path_cells_us);
+    // Fisher-Yates shuffle
+    for (size_t i = edges.size(); i > 1; --i) {
+        swap(edges[i - 1], edges[random.next_below(i)]);
+    }
+
+    DisjointSet sets(cell_count);
+    size_t passages_left = cell_count - 1;
+
+    for (uint32_t edge : edges) {
+        if (passages_left == 0) {
+            break;
+        }
+        uint32_t index = edge >> 1;
+        bool south = edge & 1;
+        uint32_t neighbor_index = south ? index + width : index + 1;
+
+        if (sets.unite(index, neighbor_index)) {
+            open_passage(index / width, index % width, south ? Side::BOTTOM : Side::RIGHT);
+            passages_left--;
+            MAZE_COUNT_VISIT(neighbor_index);
+        }
+    }
+
+    // merged forests have no root until the last passage, so the tree is read off afterwards
+    if (!tree_parents.empty()) {
+        record_tree_by_walk();
+    }
+}
+
+void Maze::create_maze_prim() {
+    size_t cell_count = static_cast<size_t>(width) * height;
+    vector<uint8_t> state(cell_count);
+    vector<size_t> frontier(cell_count);
+    MAZE_COUNT_ALLOCATION(cell_count * (sizeof(uint8_t) + sizeof(size_t)));
+    uint64_t* parents = tree_parents.empty() ? nullptr : tree_parents.data();
+    size_t root = generate_prim(*this, random, state.data(), frontier.data(), parents);
+    if (parents) {
+        root_tree_at_origin(root);
     }
-    refresh();
-    getch();
-    endwin();
+}
+
+void Maze::create_maze_aldous_broder() {
+    // random walk, the passage is opened whenever the walk enters a cell for the first time.
+    // produces a uniform spanning tree but needs many steps to cover every cell
+    const Side sides[] = {Side::TOP, Side::RIGHT, Side::BOTTOM, Side::LEFT};
+
+    vector<bool> visited(static_cast<size_t>(width) * height, false);
+    size_t index = random.next_below(visited.size());
+    size_t root = index;
+    visited[index] = true;
+    MAZE_COUNT_ALLOCATION(visited.size() / 8);
+    MAZE_COUNT_VISIT(index);
+    size_t cells_left = visited.size() - 1;
+
+    while (cells_left > 0) {
+        int row = index / width;
+        int col = index % width;
+        Side side = sides[random.next_below(4)];
+        if (!has_neighbor(row, col, side)) {
+            continue;
+        }
+
+        size_t neighbor_index = index + get_index_offset(side);
+        if (!visited[neighbor_index]) {
+            open_passage(row, col, side);
+            if (!tree_parents.empty()) {
+                set_tree_parent(neighbor_index, get_opposite_side(side));
+            }
+            visited[neighbor_index] = true;
+            cells_left--;
+            MAZE_COUNT_VISIT(neighbor_index);
+        }
+        index = neighbor_index;
+    }
+
+    if (!tree_parents.empty()) {
+        root_tree_at_origin(root);
+    }
+}
+
+void Maze::create_maze_eller() {
+    // seeded like the streaming generator, so a streamed maze matches the in-memory one
+    EllerGenerator eller(width, height, seed);
+    vector<uint8_t> walls;
+
+    while (eller.has_next_row()) {
+        int row = eller.get_row();
+        eller.next_row(walls);
+        for (int col = 0; col < width; ++col) {
+            grid.set_east_wall(row, col, walls[col] & EllerGenerator::EAST_WALL);
+            grid.set_south_wall(row, col, walls[col] & EllerGenerator::SOUTH_WALL);
+            MAZE_COUNT_VISIT(static_cast<size_t>(row) * width + col);
+        }
+    }
+
+    // sets of a row are merged in any order, so the tree is read off afterwards
+    if (!tree_parents.empty()) {
+        record_tree_by_walk();
+    }
+}
+
+int Maze::get_raw_index(int s) {
+    return s * 2 + 1;
+}
+
+void Maze::initialize_random_maze() {
+    MAZE_PHASE(Phase::GENERATE);
+    // carving the maze doesn't count as editing it
+    logging_wall_changes = false;
+    fill_borders();
+    switch(generator) {
+        case Generator::DFS:
+            create_maze_randomized_dfs();
+            break;
+        case Generator::KRUSKAL:
+            create_maze_kruskal();
+            break;
+        case Generator::PRIM:
+            create_maze_prim();
+            break;
+        case Generator::ALDOUS_BRODER:
+            create_maze_aldous_broder();
+            break;
+        case Generator::ELLER:
+            create_maze_eller();
+            break;
+        default:
+            throw;
+    }
+
+    start_location = make_pair(0,0);
+    end_location = make_pair(height - 1, width - 1);
+
+    logging_wall_changes = true;
+}
+
+void Maze::display_maze() {
+    MazeRenderer renderer(*this);
+    renderer.run();
 }
 
 Maze::Maze() : Maze(DEFAULT_SIZE, DEFAULT_SIZE) {}
 
-Maze::Maze(int w, int h) : width(w), height(h) {
-    srand(time(NULL));
-    cout << "Initializing maze with height: " << height << " and width: " << width << endl;
-    grid = make_unique<GridValue[]>(get_raw_index(width) * get_raw_index(height));
-    fill(grid.get(), grid.get() + get_raw_index(width) * get_raw_index(height), GridValue::EMPTY);
+Maze::Maze(int w, int h) : Maze(w, h, Random::make_seed()) {}
+
+Maze::Maze(int w, int h, uint64_t s) : Maze(w, h, s, Generator::DFS) {}
+
+Maze::Maze(int w, int h, uint64_t s, Generator g) : Maze(w, h, s, g, false) {}
+
+Maze::Maze(int w, int h, uint64_t s, Generator g, bool record_tree)
+    : Maze(w, h, s, g, record_tree, WallGrid::Layout::ROW_MAJOR) {}
+
+Maze::Maze(int w, int h, uint64_t s, Generator g, bool record_tree, WallGrid::Layout layout)
+    : width(w), height(h), seed(s), generator(g), random(s) {
+    // the walls and the tree are allocated for generation
+    MAZE_PHASE(Phase::GENERATE);
+    grid = WallGrid(height, width, layout);
+    if (record_tree) {
+        tree_parents.assign((static_cast<size_t>(width) * height + 31) / 32, 0);
+        MAZE_COUNT_ALLOCATION(tree_parents.size() * sizeof(uint64_t));
+    }
     initialize_random_maze();
     path = Path();
 }
 
+Maze::Maze(const MazeFileHeader& header, WallGrid g)
+    : height(header.height), width(header.width),
+      start_location(header.start_row, header.start_col), end_location(header.end_row, header.end_col),
+      seed(header.seed), generator(Generator(header.generator)), random(header.seed), grid(move(g)) {}
+
+MazeFileHeader Maze::get_file_header() const {
+    MazeFileHeader header = make_maze_file_header(width, height);
+    header.start_row = start_location.first;
+    header.start_col = start_location.second;
+    header.end_row = end_location.first;
+    header.end_col = end_location.second;
+    header.seed = seed;
+    header.generator = static_cast<uint32_t>(generator);
+    return header;
+}
+
+const uint64_t* Maze::get_row_major_walls(WallGrid& scratch) const {
+    if (grid.get_layout() == WallGrid::Layout::ROW_MAJOR) {
+        return grid.get_wall_words();
+    }
+    scratch = grid.copy_walls(WallGrid::Layout::ROW_MAJOR);
+    return scratch.get_wall_words();
+}
+
+void Maze::save(const string& filename) const {
+    MazeFileHeader header = get_file_header();
+    WallGrid scratch;
+
+    ofstream out(filename, ios::binary);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(get_row_major_walls(scratch)), header.wall_word_count * sizeof(uint64_t));
+    out.close();
+    if (!out) {
+        throw runtime_error("Could not write maze file " + filename);
+    }
+}
+
+Maze Maze::open_mapped(const string& filename) {
+    auto file = make_shared<MappedFile>(filename);
+    const MazeFileHeader& header = validate_maze_file(*file);
+    uint64_t* words = reinterpret_cast<uint64_t*>(static_cast<char*>(file->get_data()) + sizeof(MazeFileHeader));
+    return Maze(header, WallGrid(header.height, header.width, words, file));
+}
+
+uint64_t Maze::get_seed() const {
+    return seed;
+}
+
+WallGrid::Layout Maze::get_layout() const {
+    return grid.get_layout();
+}
+
+Maze::Generator Maze::get_generator() const {
+    return generator;
+}
+
+vector<string> get_generator_names() {
+    return {"dfs", "kruskal", "prim", "aldous-broder", "eller"};
+}
+
+string get_generator_name(Maze::Generator generator) {
+    return get_generator_names().at(static_cast<int>(generator));
+}
+
+bool parse_generator(const string& name, Maze::Generator& generator) {
+    if (name == "dfs") {
+        generator = Maze::Generator::DFS;
+    } else if (name == "kruskal") {
+        generator = Maze::Generator::KRUSKAL;
+    } else if (name == "prim") {
+        generator = Maze::Generator::PRIM;
+    } else if (name == "aldous-broder") {
+        generator = Maze::Generator::ALDOUS_BRODER;
+    } else if (name == "eller") {
+        generator = Maze::Generator::ELLER;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+int Maze::get_height() const {
+    return height;
+}
+
+int Maze::get_width() const {
+    return width;
+}
+
+pair<int,int> Maze::get_start_location() const {
+    return start_location;
+}
+
+pair<int,int> Maze::get_end_location() const {
+    return end_location;
+}
+
+const Path& Maze::get_path() const {
+    return path;
+}
+
+void Maze::set_path(Path p) {
+    path = move(p);
+}
+
 Maze::Side Maze::get_wall_between_cells(pair<int,int> cell1, pair<int,int> cell2) {
     pair<int,int> diff = make_pair(cell2.first - cell1.first, cell2.second - cell1.second);
 
@@ -450,66 +864,57 @@ void Maze::set_wall_between_cells(pair<int,int> cell1, pair<int,int> cell2, Grid
     set_raw(wall_raw.first, wall_raw.second, value);
 }
 
-void Maze::solveMazeDFS() {
-    // from start index, dfs, keeping history. if you have to backtrack, pop from history
-    // final result is what is in history
-
-    stack<pair<int,int>> s;
-    map<pair<int,int>, pair<int,int>> history; // key = cell, value = parent cell to get to key
-    vector<vector<bool>> visited(height, vector<bool>(width, false));
-
-    map<Side, string> side_to_str_mapping{
-        {Side::TOP, "top"},
-        {Side::BOTTOM, "bottom"},
-        {Side::LEFT, "left"},
-        {Side::RIGHT, "right"}
-    };
-
-    s.push(start_location);
-    
-    while (!s.empty()) {
-        pair<int,int> curr_cell = s.top();
-        s.pop();
-
-        if (visited[curr_cell.first][curr_cell.second]) {
-            continue;
-        }
-
-        vector<pair<int,int>> neighbors = get_neighbors(curr_cell.first, curr_cell.second);
-
-        int num_added = 0;
-        
-        for (auto neighbor : neighbors) {
-            if (visited[neighbor.first][neighbor.second]) {
-                continue;
-            }
-            Side wall = get_wall_between_cells(curr_cell, neighbor);
-            GridValue wall_value = get_wall_value(curr_cell.first, curr_cell.second, wall);
-
-            if (wall_value == GridValue::EMPTY) { // if wall is down
-                s.push(neighbor);
-                num_added++;
-                history[neighbor] = curr_cell;
-            }
-        }
-
-        visited[curr_cell.first][curr_cell.second] = true;
+bool Maze::is_passage_open(int row, int col, Side side) const {
+    switch(side) {
+        case Side::TOP:
+            return row > 0 && !grid.has_south_wall(row - 1, col);
+        case Side::BOTTOM:
+            return row < height - 1 && !grid.has_south_wall(row, col);
+        case Side::LEFT:
+            return col > 0 && !grid.has_east_wall(row, col - 1);
+        case Side::RIGHT:
+            return col < width - 1 && !grid.has_east_wall(row, col);
+        default:
+            throw;
     }
+}
 
-    // add history cells to grid
-    // also add path to no wall locations
-    cout << "Len of history " << history.size() << endl;
-    pair<int,int> prev{-1,-1};
-
-    pair<int,int> curr_path_cell = end_location;
-    vector<pair<int,int>> path_to_add{};
+void Maze::get_row_walls(int row, uint64_t* east_walls, uint64_t* south_walls) const {
+    assert(row >= 0 && row < height);
+    int word_count = (width + 63) / 64;
+    fill(east_walls, east_walls + word_count, 0);
+    fill(south_walls, south_walls + word_count, 0);
+    grid.get_row_walls(row, east_walls, south_walls);
+
+    // the words past the width count as walls
+    if (width % 64 != 0) {
+        uint64_t past_width = ~uint64_t(0) << (width % 64);
+        east_walls[word_count - 1] |= past_width;
+        south_walls[word_count - 1] |= past_width;
+    }
+}
 
-    while (prev != start_location) {
-        prev = curr_path_cell;
-        path_to_add.push_back(curr_path_cell);
-        curr_path_cell = history[curr_path_cell];
+ptrdiff_t Maze::get_index_offset(Side side) const {
+    switch(side) {
+        case Side::TOP:
+            return -static_cast<ptrdiff_t>(width);
+        case Side::BOTTOM:
+            return width;
+        case Side::LEFT:
+            return -1;
+        case Side::RIGHT:
+            return 1;
+        default:
+            throw;
     }
+}
+
+void Maze::solveMazeDFS() {
+    SolverWorkspace workspace;
+    solveMazeDFS(workspace);
+}
 
-    reverse(path_to_add.begin(), path_to_add.end());
-    path = Path(path_to_add);
+void Maze::solveMazeDFS(SolverWorkspace& workspace) {
+    DFSSolver solver;
+    path = solver.solve(*this, start_location, end_location, workspace);
 }
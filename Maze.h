@@ -2,17 +2,77 @@
 
 #include <vector>
 #include <memory>
+#include <string>
 #include "Path.h"
+#include "WallGrid.h"
+#include "SolverWorkspace.h"
+#include "Random.h"
+
+struct MazeFileHeader;
 
 class Maze {
+    // draws the raw grid
+    friend class MazeRenderer;
+    // compress and restore the wall words
+    friend class MazeArchive;
+    friend class MazeArchiveWriter;
+
+public:
     enum class Side { TOP, LEFT, BOTTOM, RIGHT };
+    enum class Generator { DFS, KRUSKAL, PRIM, ALDOUS_BRODER, ELLER };
+
+    // a wall that was built or removed, on the given side of the cell
+    struct WallChange {
+        int row;
+        int col;
+        Side side;
+    };
+
+private:
+    // unique number of a maze object, copies and assignments draw a new one
+    class Identity {
+        uint64_t value;
+
+    public:
+        Identity();
+        Identity(const Identity&);
+        Identity& operator=(const Identity&);
+        uint64_t get() const;
+    };
+
     enum class GridValue {EMPTY, PATH, WALL};
     int height;
     int width;
     std::pair<int,int> start_location;
     std::pair<int,int> end_location;
-    std::unique_ptr<GridValue[]> grid;
+    uint64_t seed;
+    Generator generator;
+    Random random;
+    WallGrid grid;
     Path path;
+    Identity identity;
+    // number of wall edits since the maze was created, the last ones are kept in wall_changes
+    uint64_t revision = 0;
+    // allocated by the first edit after generation
+    std::vector<WallChange> wall_changes;
+    // false while generating, carving the maze doesn't count as editing it
+    bool logging_wall_changes = true;
+    // side towards the parent of every cell in the spanning tree rooted at (0,0), recorded while
+    // generating if asked for. step i is bits 2 * (i % 32) of word i / 32, like the steps of a Path
+    std::vector<uint64_t> tree_parents;
+
+    // returns the side towards the parent of a cell in the spanning tree
+    Side get_tree_parent(size_t index) const;
+    void set_tree_parent(size_t index, Side side);
+
+    // turns the recorded tree around so it is rooted at (0,0) instead of old_root
+    void root_tree_at_origin(size_t old_root);
+
+    // fills the tree with one walk over the finished maze, for generators that don't grow a tree
+    void record_tree_by_walk();
+
+    // counts a wall edit and keeps it in the change log
+    void record_wall_change(int row, int col, Side side);
 
     /*
     * Asserts that row and col inputs are valid for a cell coordinate.
@@ -75,9 +135,19 @@ class Maze {
     // get value at grid with raw coordinates
     GridValue get_raw(int y, int x);
 
-    // set value at grid with raw coordinates
+    /*
+    * Set value at grid with raw coordinates.
+    * Corner posts and the top and left borders are fixed walls, setting them is a no-op.
+    * Cells can only be set to EMPTY or PATH.
+    */
     void set_raw(int y, int x, GridValue value);
 
+    // sets the wall bits and path bit of a stored wall (east or south of a cell)
+    void set_stored_wall(int row, int col, bool east, GridValue value);
+
+    // gets value of a stored wall (east or south of a cell)
+    GridValue get_stored_wall(int row, int col, bool east);
+
     // get cell coordinates of neighbors of current cell
     std::vector<std::pair<int,int>> get_neighbors(int row, int col);
 
@@ -94,7 +164,7 @@ class Maze {
     void initialize_random_maze();
 
     /*
-    * Sets all outer borders of mazes to true (walls).
+    * Builds every wall of the maze, which includes its outer borders.
     */
     void fill_borders();
 
@@ -107,12 +177,33 @@ class Maze {
     // do a randomized bfs to create the maze
     void create_maze_randomized_dfs();
 
+    // removes walls in random order when they separate unconnected cells, using a DisjointSet
+    void create_maze_kruskal();
+
+    // grows the maze from a random cell by connecting random cells of its frontier
+    void create_maze_prim();
+
+    // random walk that connects every cell the first time it is entered
+    void create_maze_aldous_broder();
+
+    // fills the grid row by row from an EllerGenerator
+    void create_maze_eller();
+
     // returns grid size associated with abstract size
     int get_raw_index(int);
 
+    // initializes a maze from a file header and its walls, without generating anything
+    Maze(const MazeFileHeader& header, WallGrid grid);
+
+    // returns the header of a maze file holding this maze
+    MazeFileHeader get_file_header() const;
+
+    // returns the wall words in the ROW_MAJOR layout of maze files, converted into scratch if needed
+    const uint64_t* get_row_major_walls(WallGrid& scratch) const;
+
 public:
     /**
-    * Displays maze to cout stream. 1 = wall, 0 = empty space.
+    * Displays the maze with ncurses and animates its path, see MazeRenderer.
     */
     void display_maze();
 
@@ -122,15 +213,183 @@ public:
     Maze();
 
     /*
-    * Initializes a maze of specified width and height.
+    * Initializes a maze of specified width and height with a fresh random seed.
 
     @param width width of maze grid
     @param heigh height of maze grid
     */
     Maze(int width, int height);
 
+    /*
+    * Initializes a maze of specified width and height, generated from the given seed.
+    * The same seed and size always produce the same maze.
+
+    @param width width of maze grid
+    @param heigh height of maze grid
+    @param seed seed for the random generator
+    */
+    Maze(int width, int height, uint64_t seed);
+
+    /*
+    * Initializes a maze of specified width and height with the given generation algorithm.
+
+    @param width width of maze grid
+    @param heigh height of maze grid
+    @param seed seed for the random generator
+    @param generator algorithm used to create the maze
+    */
+    Maze(int width, int height, uint64_t seed, Generator generator);
+
+    /*
+    * Initializes a maze with the given generation algorithm and, if record_tree is set, keeps the
+    * spanning tree the generator grew at 2 bits per cell, see get_tree_path.
+
+    @param width width of maze grid
+    @param heigh height of maze grid
+    @param seed seed for the random generator
+    @param generator algorithm used to create the maze
+    @param record_tree keep the spanning tree
+    */
+    Maze(int width, int height, uint64_t seed, Generator generator, bool record_tree);
+
+    /*
+    * Initializes a maze like above with its walls stored in the given layout. The layout only
+    * changes memory order, the same seed gives the same maze and the same saved file.
+
+    @param width width of maze grid
+    @param heigh height of maze grid
+    @param seed seed for the random generator
+    @param generator algorithm used to create the maze
+    @param record_tree keep the spanning tree
+    @param layout order of the cells in memory, see WallGrid::Layout
+    */
+    Maze(int width, int height, uint64_t seed, Generator generator, bool record_tree, WallGrid::Layout layout);
+
+    // returns the seed the maze was generated from
+    uint64_t get_seed() const;
+
+    // returns the memory layout of the walls
+    WallGrid::Layout get_layout() const;
+
+    // returns the algorithm the maze was generated with
+    Generator get_generator() const;
+
+    /*
+    * Writes size, start/end locations, seed and packed walls to a binary maze file (see MazeFile.h).
+    * Throws std::runtime_error if the file can't be written.
+    */
+    void save(const std::string& filename) const;
+
+    /*
+    * Opens a maze file by mapping it into memory. The walls are read straight from the mapped
+    * pages, nothing is parsed or copied, and pages are only loaded from disk when first touched.
+    * Throws std::runtime_error if the file is missing or not a valid maze file.
+    */
+    static Maze open_mapped(const std::string& filename);
+
+    int get_height() const;
+    int get_width() const;
+
+    std::pair<int,int> get_start_location() const;
+    std::pair<int,int> get_end_location() const;
+
+    // returns the path found by the last solve
+    const Path& get_path() const;
+
+    // replaces the path, e.g. with the result of a Solver
+    void set_path(Path path);
+
+    // returns true if the cell has a neighbor on that side
+    bool has_neighbor(int row, int col, Side side) const;
+
+    // returns true if the cell has a neighbor on that side and no wall in between
+    bool is_passage_open(int row, int col, Side side) const;
+
+    // removes the wall on the given side of the cell, the neighbor must exist
+    void open_passage(int row, int col, Side side);
+
+    /*
+    * Builds or removes the wall on the given side of the cell, the neighbor must exist.
+    * Every edit after generation, including open_passage, bumps the revision and is kept in the
+    * change log.
+    */
+    void set_wall(int row, int col, Side side, bool built);
+
+    /*
+    * Removes each built inner wall with the given probability, which adds loops to a perfect
+    * maze. Every removal is a set_wall edit rather than a remove_wall, which is private and
+    * doesn't bump the revision, so LPA* and HPAIndex::update() see the new passages.
+    */
+    void braid(double fraction);
+
+    // number of wall edits since the maze was created or loaded
+    uint64_t get_revision() const;
+
+    /*
+    * Returns a number no other maze object in the process has, so state derived from a maze can
+    * be keyed on (id, revision). A copy or an assigned-to maze gets a new id.
+    */
+    uint64_t get_id() const;
+
+    // returns a hash of the size and every wall, equal for mazes with the same walls
+    uint64_t get_wall_hash() const;
+
+    // returns true if the spanning tree was recorded while generating and no wall changed since
+    bool has_spanning_tree() const;
+
+    /*
+    * Returns the path from (0,0) to the cell, read off the spanning tree without searching, in
+    * O(path length). The maze must have a spanning tree.
+    */
+    Path get_tree_path(std::pair<int,int> cell) const;
+
+    /*
+    * Appends the wall edits made after the given revision to changes, oldest first. Only the last
+    * WALL_CHANGE_LOG_SIZE edits are kept.
+    * @return false if some of those edits are no longer in the log
+    */
+    bool get_wall_changes(uint64_t since_revision, std::vector<WallChange>& changes) const;
+
+    static const size_t WALL_CHANGE_LOG_SIZE = 4096;
+
+    /*
+    * Writes the walls of a row as bit rows, bit col % 64 of word col / 64 is set if the east
+    * (or south) wall of cell col is built. Bits past the width are set, whatever the grid
+    * left there.
+    * @param east_walls (width + 63) / 64 words
+    * @param south_walls (width + 63) / 64 words
+    */
+    void get_row_walls(int row, uint64_t* east_walls, uint64_t* south_walls) const;
+
+    // returns the side facing the given one, e.g. TOP for BOTTOM
+    static constexpr Side get_opposite_side(Side side) {
+        // TOP <-> BOTTOM, LEFT <-> RIGHT
+        return Side((static_cast<int>(side) + 2) % 4);
+    }
+
+    // returns the difference in flat cell index (row * width + col) when moving towards side
+    ptrdiff_t get_index_offset(Side side) const;
+
     // solves maze using DFS method and updates grid with its path
     void solveMazeDFS();
+
+    /*
+    * Solves maze using DFS method with the given workspace and updates grid with its path.
+    * Reuse the workspace across solves of same-sized mazes to avoid reallocating it.
+    */
+    void solveMazeDFS(SolverWorkspace& workspace);
 };
 
 extern const int DEFAULT_SIZE;
+
+// returns names accepted by parse_generator, in the order of Maze::Generator
+std::vector<std::string> get_generator_names();
+
+// returns the name of a generator, e.g. "dfs"
+std::string get_generator_name(Maze::Generator generator);
+
+/*
+* Parses a generator name (dfs, kruskal, prim, aldous-broder or eller).
+* @return false if the name is not a known generator.
+*/
+bool parse_generator(const std::string& name, Maze::Generator& generator);
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "Instrument.h"
+#include "Maze.h"
+#include "Path.h"
+#include "Random.h"
+
+/*
+* Randomized Prim generation and breadth first search, written once for any maze type and shared
+* by the dynamic Maze and the compile-time sized FixedMaze. The other algorithms are Maze only.
+*
+* A maze type provides get_height(), get_width(), has_neighbor(row, col, side),
+* is_passage_open(row, col, side), open_passage(row, col, side) and get_index_offset(side), with
+* cells addressed by flat index row * width + col. Scratch memory is passed in by the caller, so
+* the algorithms themselves never allocate.
+*/
+
+/*
+* Randomized Prim: grows the maze from a random cell, each step connects a random frontier cell
+* (a cell next to the maze) to a random neighbor that is already part of the maze.
+* @param state one byte per cell
+* @param frontier one index per cell
+* @param tree_parents nullptr, or 2 bits per cell packed like Path steps, zeroed, that receive the
+*        side towards the parent of every cell in the spanning tree the maze grew as
+* @return flat index of the cell the maze grew from, the root of that tree
+*/
+template <class MazeType>
+size_t generate_prim(MazeType& maze, Random& random, uint8_t* state, size_t* frontier,
+    uint64_t* tree_parents = nullptr) {
+    // cells are OUT, FRONTIER or IN. the frontier is a flat array of cell indices,
+    // a random one is taken out by swapping it with the last element
+    using Side = Maze::Side;
+    const uint8_t OUT = 0, FRONTIER = 1, IN = 2;
+    const Side sides[] = {Side::TOP, Side::RIGHT, Side::BOTTOM, Side::LEFT};
+
+    int width = maze.get_width();
+    size_t cell_count = static_cast<size_t>(width) * maze.get_height();
+    size_t frontier_size = 0;
+    for (size_t i = 0; i < cell_count; ++i) {
+        state[i] = OUT;
+    }
+
+    auto add_to_maze = [&](size_t index) {
+        state[index] = IN;
+        MAZE_COUNT_VISIT(index);
+        int row = index / width;
+        int col = index % width;
+        for (Side side : sides) {
+            if (!maze.has_neighbor(row, col, side)) {
+                continue;
+            }
+            size_t neighbor_index = index + maze.get_index_offset(side);
+            if (state[neighbor_index] == OUT) {
+                state[neighbor_index] = FRONTIER;
+                frontier[frontier_size++] = neighbor_index;
+            }
+        }
+        MAZE_TRACK_FRONTIER(frontier_size);
+    };
+
+    size_t root = random.next_below(cell_count);
+    add_to_maze(root);
+
+    while (frontier_size > 0) {
+        size_t i = random.next_below(frontier_size);
+        size_t index = frontier[i];
+        frontier[i] = frontier[--frontier_size];
+
+        // connect to a random neighbor that is already part of the maze
+        int row = index / width;
+        int col = index % width;
+        Side in_sides[4];
+        int in_count = 0;
+        for (Side side : sides) {
+            if (maze.has_neighbor(row, col, side) && state[index + maze.get_index_offset(side)] == IN) {
+                in_sides[in_count++] = side;
+            }
+        }
+        Side side = in_sides[random.next_below(in_count)];
+        maze.open_passage(row, col, side);
+        if (tree_parents) {
+            tree_parents[index / 32] |= static_cast<uint64_t>(side) << (2 * (index % 32));
+        }
+
+        add_to_maze(index);
+    }
+    return root;
+}
+
+/*
+* Breadth first search from start_index until end_index is expanded. Marks every reached cell
+* visited in the workspace and stores the side towards its parent, as a Maze::Side value.
+* @param workspace provides is_visited, mark_visited and set_parent, already reset
+* @param queue empty, provides push_back, size and operator[], grows to at most one entry per cell
+* @return true if end_index was reached
+*/
+template <class MazeType, class Workspace, class Queue>
+bool breadth_first_search(const MazeType& maze, size_t start_index, size_t end_index,
+    Workspace& workspace, Queue& queue, size_t& nodes_expanded) {
+    using Side = Maze::Side;
+    // order in which neighbors are pushed, same as Maze::get_neighbors
+    const Side sides[] = {Side::TOP, Side::RIGHT, Side::BOTTOM, Side::LEFT};
+    int width = maze.get_width();
+    // every cell is pushed once, so the queue is read from head and never popped
+    size_t head = 0;
+
+    workspace.mark_visited(start_index);
+    queue.push_back(start_index);
+
+    while (head < queue.size()) {
+        size_t curr_index = queue[head++];
+        nodes_expanded++;
+        if (curr_index == end_index) {
+            break;
+        }
+
+        int row = curr_index / width;
+        int col = curr_index % width;
+
+        for (Side side : sides) {
+            if (!maze.is_passage_open(row, col, side)) {
+                continue;
+            }
+            size_t neighbor_index = curr_index + maze.get_index_offset(side);
+            if (workspace.is_visited(neighbor_index)) {
+                continue;
+            }
+            workspace.mark_visited(neighbor_index);
+            workspace.set_parent(neighbor_index, static_cast<uint8_t>(Maze::get_opposite_side(side)));
+            queue.push_back(neighbor_index);
+        }
+        MAZE_TRACK_FRONTIER(queue.size() - head);
+    }
+    return workspace.is_visited(end_index);
+}
+
+/*
+* Appends the cells from `from` up to and including `root` to the path, following the parents
+* in the workspace. An empty path starts at `from`.
+*/
+template <class MazeType, class Workspace>
+void append_parent_chain(const MazeType& maze, const Workspace& workspace, size_t from, size_t root, Path& path) {
+    using Side = Maze::Side;
+    int width = maze.get_width();
+    path.add(static_cast<int>(from / width), static_cast<int>(from % width));
+    while (from != root) {
+        Side parent = Side(workspace.get_parent(from));
+        from += maze.get_index_offset(parent);
+        path.add_step(Path::Step(parent));
+    }
+}
@@ -0,0 +1,416 @@
+#include "MazeArchive.h"
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "Instrument.h"
+#include "WallGrid.h"
+
+using namespace std;
+
+static const char MAZE_ARCHIVE_MAGIC[8] = {'M', 'A', 'Z', 'E', 'A', 'R', 'C', 'H'};
+static const char MAZE_ARCHIVE_INDEX_MAGIC[8] = {'M', 'A', 'Z', 'E', 'I', 'N', 'D', 'X'};
+static const uint32_t MAZE_ARCHIVE_VERSION = 1;
+
+static const int EAST_BIT = 0;
+static const int SOUTH_BIT = 1;
+
+// wall contexts per direction, 6 neighboring wall bits each
+static const int CONTEXT_COUNT = 64;
+
+// probabilities are 11 bit fixed point estimates of a 0 (open) bit, adapted by 1/32 per bit
+static const int PROBABILITY_BITS = 11;
+static const uint16_t PROBABILITY_HALF = 1 << (PROBABILITY_BITS - 1);
+static const int ADAPT_SHIFT = 5;
+static const uint32_t RANGE_TOP = 1 << 24;
+
+/*
+* Binary range encoder in the style of LZMA: the range is split in proportion to the probability
+* of the bit, carries are propagated through a cached byte and a run of 0xFF bytes.
+*/
+class RangeEncoder {
+    vector<uint8_t>& out;
+    uint64_t low;
+    uint32_t range;
+    uint8_t cache;
+    uint64_t cache_size;
+
+    void shift_low() {
+        if (static_cast<uint32_t>(low) < 0xFF000000u || (low >> 32) != 0) {
+            uint8_t carry = static_cast<uint8_t>(low >> 32);
+            uint8_t byte = cache;
+            do {
+                out.push_back(byte + carry);
+                byte = 0xFF;
+            } while (--cache_size != 0);
+            cache = static_cast<uint8_t>(low >> 24);
+        }
+        cache_size++;
+        low = (low & 0x00FFFFFF) << 8;
+    }
+
+public:
+    explicit RangeEncoder(vector<uint8_t>& o) : out(o), low(0), range(0xFFFFFFFF), cache(0), cache_size(1) {}
+
+    void encode(uint16_t& probability, uint32_t bit) {
+        uint32_t bound = (range >> PROBABILITY_BITS) * probability;
+        if (bit == 0) {
+            range = bound;
+            probability += ((1 << PROBABILITY_BITS) - probability) >> ADAPT_SHIFT;
+        } else {
+            low += bound;
+            range -= bound;
+            probability -= probability >> ADAPT_SHIFT;
+        }
+        while (range < RANGE_TOP) {
+            range <<= 8;
+            shift_low();
+        }
+    }
+
+    void flush() {
+        for (int i = 0; i < 5; ++i) {
+            shift_low();
+        }
+    }
+};
+
+class RangeDecoder {
+    const uint8_t* data;
+    const uint8_t* end;
+    uint32_t range;
+    uint32_t code;
+
+    // a truncated record reads as zeros, a corrupt one decodes to some maze
+    uint8_t next_byte() {
+        return data < end ? *data++ : 0;
+    }
+
+public:
+    RangeDecoder(const uint8_t* d, size_t size) : data(d), end(d + size), range(0xFFFFFFFF), code(0) {
+        for (int i = 0; i < 5; ++i) {
+            code = (code << 8) | next_byte();
+        }
+    }
+
+    uint32_t decode(uint16_t& probability) {
+        uint32_t bound = (range >> PROBABILITY_BITS) * probability;
+        uint32_t bit;
+        if (code < bound) {
+            range = bound;
+            probability += ((1 << PROBABILITY_BITS) - probability) >> ADAPT_SHIFT;
+            bit = 0;
+        } else {
+            code -= bound;
+            range -= bound;
+            probability -= probability >> ADAPT_SHIFT;
+            bit = 1;
+        }
+        if (range < RANGE_TOP) {
+            range <<= 8;
+            code = (code << 8) | next_byte();
+        }
+        return bit;
+    }
+};
+
+// returns a wall bit in the layout of WallGrid::get_wall_words(), cells outside the maze are walls
+static inline uint32_t get_wall(const uint64_t* words, int width, int row, int col, int bit) {
+    if (row < 0 || col < 0 || col >= width) {
+        return 1;
+    }
+    size_t index = static_cast<size_t>(row) * width + col;
+    return (words[index >> 5] >> (((index & 31) << 1) + bit)) & 1;
+}
+
+static inline void clear_wall(uint64_t* words, int width, int row, int col, int bit) {
+    size_t index = static_cast<size_t>(row) * width + col;
+    words[index >> 5] &= ~(uint64_t(1) << (((index & 31) << 1) + bit));
+}
+
+/*
+* Context of the east wall of a cell, from the walls around it that come earlier in row order:
+* the walls west and north of it and the walls the corridor it continues would have.
+*/
+static inline uint32_t get_east_context(const uint64_t* words, int width, int row, int col) {
+    return get_wall(words, width, row, col - 1, EAST_BIT)
+        | get_wall(words, width, row, col - 1, SOUTH_BIT) << 1
+        | get_wall(words, width, row - 1, col, SOUTH_BIT) << 2
+        | get_wall(words, width, row - 1, col, EAST_BIT) << 3
+        | get_wall(words, width, row - 1, col + 1, SOUTH_BIT) << 4
+        | get_wall(words, width, row, col - 2, EAST_BIT) << 5;
+}
+
+// context of the south wall of a cell, its east wall is already known
+static inline uint32_t get_south_context(const uint64_t* words, int width, int row, int col) {
+    return get_wall(words, width, row, col, EAST_BIT)
+        | get_wall(words, width, row, col - 1, EAST_BIT) << 1
+        | get_wall(words, width, row - 1, col, SOUTH_BIT) << 2
+        | get_wall(words, width, row, col - 1, SOUTH_BIT) << 3
+        | get_wall(words, width, row - 1, col, EAST_BIT) << 4
+        | get_wall(words, width, row - 1, col - 1, SOUTH_BIT) << 5;
+}
+
+// codes the inner walls of a grid, border walls are implied
+static void encode_walls(const uint64_t* words, int height, int width, vector<uint8_t>& out) {
+    vector<uint16_t> east(CONTEXT_COUNT, PROBABILITY_HALF);
+    vector<uint16_t> south(CONTEXT_COUNT, PROBABILITY_HALF);
+    RangeEncoder encoder(out);
+    for (int row = 0; row < height; ++row) {
+        for (int col = 0; col < width; ++col) {
+            if (col < width - 1) {
+                encoder.encode(east[get_east_context(words, width, row, col)], get_wall(words, width, row, col, EAST_BIT));
+            }
+            if (row < height - 1) {
+                encoder.encode(south[get_south_context(words, width, row, col)], get_wall(words, width, row, col, SOUTH_BIT));
+            }
+        }
+    }
+    encoder.flush();
+}
+
+// decodes into words that start with every wall built
+static void decode_walls(const uint8_t* data, size_t size, int height, int width, uint64_t* words) {
+    vector<uint16_t> east(CONTEXT_COUNT, PROBABILITY_HALF);
+    vector<uint16_t> south(CONTEXT_COUNT, PROBABILITY_HALF);
+    RangeDecoder decoder(data, size);
+    for (int row = 0; row < height; ++row) {
+        for (int col = 0; col < width; ++col) {
+            if (col < width - 1 && !decoder.decode(east[get_east_context(words, width, row, col)])) {
+                clear_wall(words, width, row, col, EAST_BIT);
+            }
+            if (row < height - 1 && !decoder.decode(south[get_south_context(words, width, row, col)])) {
+                clear_wall(words, width, row, col, SOUTH_BIT);
+            }
+        }
+    }
+}
+
+MazeArchiveWriter::MazeArchiveWriter(const string& filename) : fd(-1), original_size(0), end_offset(0), closed(false) {
+    fd = open(filename.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        throw runtime_error("Could not open " + filename);
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw runtime_error("Could not stat " + filename);
+    }
+
+    if (info.st_size == 0) {
+        MazeArchiveHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, MAZE_ARCHIVE_MAGIC, sizeof(header.magic));
+        header.version = MAZE_ARCHIVE_VERSION;
+        header.header_size = sizeof(MazeArchiveHeader);
+        try {
+            write_at(&header, sizeof(header), 0);
+        } catch (const runtime_error&) {
+            ::close(fd);
+            throw;
+        }
+        end_offset = sizeof(header);
+        return;
+    }
+
+    // appending: new records go after the old trailer and the index is written again after them
+    // on close, so the old index stays valid until the new one is complete
+    MazeArchiveHeader header;
+    MazeArchiveTrailer trailer;
+    size_t file_size = info.st_size;
+    bool valid = file_size >= sizeof(header) + sizeof(trailer)
+        && pread(fd, &header, sizeof(header), 0) == sizeof(header)
+        && memcmp(header.magic, MAZE_ARCHIVE_MAGIC, sizeof(header.magic)) == 0
+        && header.version == MAZE_ARCHIVE_VERSION
+        && pread(fd, &trailer, sizeof(trailer), file_size - sizeof(trailer)) == sizeof(trailer)
+        && memcmp(trailer.magic, MAZE_ARCHIVE_INDEX_MAGIC, sizeof(trailer.magic)) == 0
+        && trailer.index_offset + trailer.maze_count * sizeof(MazeArchiveEntry) + sizeof(trailer) == file_size;
+    if (valid) {
+        entries.resize(trailer.maze_count);
+        size_t index_size = entries.size() * sizeof(MazeArchiveEntry);
+        valid = pread(fd, entries.data(), index_size, trailer.index_offset) == static_cast<ssize_t>(index_size);
+    }
+    if (!valid) {
+        ::close(fd);
+        throw runtime_error(filename + " is not a complete maze archive");
+    }
+    original_size = file_size;
+    end_offset = file_size;
+}
+
+MazeArchiveWriter::~MazeArchiveWriter() {
+    try {
+        close();
+    } catch (const runtime_error&) {
+    }
+}
+
+void MazeArchiveWriter::write_at(const void* data, size_t size, uint64_t offset) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t written = pwrite(fd, bytes, size, offset);
+        if (written <= 0) {
+            throw runtime_error("Could not write maze archive");
+        }
+        bytes += written;
+        size -= written;
+        offset += written;
+    }
+}
+
+size_t MazeArchiveWriter::reserve() {
+    lock_guard<mutex> lock(append_mutex);
+    if (closed) {
+        throw runtime_error("Maze archive is closed");
+    }
+    // offset 0 marks a position whose record isn't written yet
+    entries.push_back(MazeArchiveEntry{0, 0});
+    return entries.size() - 1;
+}
+
+size_t MazeArchiveWriter::append(const Maze& maze) {
+    size_t position = reserve();
+    append(maze, position);
+    return position;
+}
+
+void MazeArchiveWriter::append(const Maze& maze, size_t position) {
+    MazeFileHeader header = maze.get_file_header();
+    vector<uint8_t> coded;
+    WallGrid scratch;
+    encode_walls(maze.get_row_major_walls(scratch), maze.get_height(), maze.get_width(), coded);
+
+    MazeArchiveEntry entry;
+    {
+        lock_guard<mutex> lock(append_mutex);
+        if (closed) {
+            throw runtime_error("Maze archive is closed");
+        }
+        if (position >= entries.size() || entries[position].offset != 0) {
+            throw runtime_error("Maze archive position " + to_string(position) + " is not reserved");
+        }
+        entry.offset = end_offset;
+        entry.size = coded.size();
+        // padding keeps every header and the index 8 byte aligned
+        end_offset += (sizeof(header) + coded.size() + 7) & ~uint64_t(7);
+    }
+    // records never overlap, so they are written without the lock. The entry is only filled
+    // once its record is complete, a failed write leaves the position unwritten
+    write_at(&header, sizeof(header), entry.offset);
+    write_at(coded.data(), coded.size(), entry.offset + sizeof(header));
+    lock_guard<mutex> lock(append_mutex);
+    entries[position] = entry;
+}
+
+size_t MazeArchiveWriter::get_maze_count() {
+    lock_guard<mutex> lock(append_mutex);
+    return entries.size();
+}
+
+void MazeArchiveWriter::close() {
+    lock_guard<mutex> lock(append_mutex);
+    if (closed) {
+        return;
+    }
+    closed = true;
+
+    bool complete = all_of(entries.begin(), entries.end(), [](const MazeArchiveEntry& entry) {
+        return entry.offset != 0;
+    });
+    if (!complete) {
+        // drops the records of this session, an archive that was appended to keeps its old index
+        bool restored = ftruncate(fd, original_size) == 0;
+        ::close(fd);
+        throw runtime_error(restored ? "Maze archive has unwritten mazes, the appended mazes were dropped"
+            : "Maze archive has unwritten mazes and could not be restored");
+    }
+
+    MazeArchiveTrailer trailer;
+    memset(&trailer, 0, sizeof(trailer));
+    memcpy(trailer.magic, MAZE_ARCHIVE_INDEX_MAGIC, sizeof(trailer.magic));
+    trailer.maze_count = entries.size();
+    trailer.index_offset = end_offset;
+    size_t index_size = entries.size() * sizeof(MazeArchiveEntry);
+    bool written = true;
+    try {
+        write_at(entries.data(), index_size, end_offset);
+        write_at(&trailer, sizeof(trailer), end_offset + index_size);
+    } catch (const runtime_error&) {
+        written = false;
+    }
+    written = ::close(fd) == 0 && written;
+    if (!written) {
+        throw runtime_error("Could not write maze archive index");
+    }
+}
+
+MazeArchive::MazeArchive(const string& filename) : file(filename), entries(nullptr), maze_count(0) {
+    const char* data = static_cast<const char*>(file.get_data());
+    size_t size = file.get_size();
+    if (size < sizeof(MazeArchiveHeader) + sizeof(MazeArchiveTrailer)) {
+        throw runtime_error(filename + " is too small for a maze archive");
+    }
+    const MazeArchiveHeader& header = *reinterpret_cast<const MazeArchiveHeader*>(data);
+    if (memcmp(header.magic, MAZE_ARCHIVE_MAGIC, sizeof(header.magic)) != 0) {
+        throw runtime_error("Not a maze archive");
+    }
+    if (header.version != MAZE_ARCHIVE_VERSION || header.header_size != sizeof(MazeArchiveHeader)) {
+        throw runtime_error("Unsupported maze archive version " + to_string(header.version));
+    }
+    const MazeArchiveTrailer& trailer = *reinterpret_cast<const MazeArchiveTrailer*>(data + size - sizeof(MazeArchiveTrailer));
+    if (memcmp(trailer.magic, MAZE_ARCHIVE_INDEX_MAGIC, sizeof(trailer.magic)) != 0
+        || trailer.index_offset < sizeof(MazeArchiveHeader)
+        || trailer.maze_count > (size - trailer.index_offset) / sizeof(MazeArchiveEntry)
+        || trailer.index_offset + trailer.maze_count * sizeof(MazeArchiveEntry) + sizeof(trailer) != size) {
+        throw runtime_error(filename + " has no valid index, it was not closed");
+    }
+    if (trailer.index_offset % alignof(MazeArchiveEntry) != 0) {
+        throw runtime_error(filename + " has a misaligned index");
+    }
+    entries = reinterpret_cast<const MazeArchiveEntry*>(data + trailer.index_offset);
+    maze_count = trailer.maze_count;
+    for (size_t i = 0; i < maze_count; ++i) {
+        if (entries[i].offset < sizeof(MazeArchiveHeader) || entries[i].offset % alignof(MazeFileHeader) != 0
+            || entries[i].offset + sizeof(MazeFileHeader) + entries[i].size > trailer.index_offset) {
+            throw runtime_error(filename + " has an index entry outside of the records");
+        }
+    }
+}
+
+size_t MazeArchive::get_maze_count() const {
+    return maze_count;
+}
+
+const MazeFileHeader& MazeArchive::get_record_header(size_t i) const {
+    if (i >= maze_count) {
+        throw out_of_range("No maze " + to_string(i) + " in the archive");
+    }
+    const char* data = static_cast<const char*>(file.get_data());
+    const MazeFileHeader& header = *reinterpret_cast<const MazeFileHeader*>(data + entries[i].offset);
+    validate_maze_file_header(header);
+    return header;
+}
+
+Maze MazeArchive::get_maze(size_t i) const {
+    const MazeFileHeader& header = get_record_header(i);
+    const uint8_t* coded = static_cast<const uint8_t*>(file.get_data()) + entries[i].offset + sizeof(MazeFileHeader);
+
+    size_t word_count = header.wall_word_count;
+    shared_ptr<uint64_t> words(new uint64_t[word_count], default_delete<uint64_t[]>());
+    fill(words.get(), words.get() + word_count, ~uint64_t(0));
+    MAZE_COUNT_ALLOCATION(word_count * sizeof(uint64_t));
+    decode_walls(coded, entries[i].size, header.height, header.width, words.get());
+    return Maze(header, WallGrid(header.height, header.width, words.get(), words));
+}
+
+uint64_t MazeArchive::get_compressed_size(size_t i) const {
+    get_record_header(i);
+    return entries[i].size;
+}
+
+uint64_t MazeArchive::get_raw_size(size_t i) const {
+    return get_record_header(i).wall_word_count * sizeof(uint64_t);
+}
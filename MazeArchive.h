@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "Maze.h"
+#include "MazeFile.h"
+
+/*
+* Archive of many mazes with compressed walls, version 1.
+*
+* A 64 byte MazeArchiveHeader, then one record per maze: its MazeFileHeader followed by the wall
+* bits coded with an adaptive binary range coder, padded to a multiple of 8 bytes. Every inner
+* wall is coded in row order with a probability learned from the walls next to it that are
+* already coded, which captures the corridors and dead ends of each generator; border walls are
+* implied. Each record is coded on its own, so any maze decodes without the others.
+*
+* The index of record offsets and sizes follows the last record, then a 64 byte
+* MazeArchiveTrailer that points to it, so a reader maps the file, reads the trailer and decodes
+* any maze straight from its offset without scanning.
+*/
+struct MazeArchiveHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    uint64_t reserved[6];
+};
+
+struct MazeArchiveEntry {
+    // file offset of the record's MazeFileHeader
+    uint64_t offset;
+    // bytes of coded walls after that header
+    uint64_t size;
+};
+
+struct MazeArchiveTrailer {
+    char magic[8];
+    uint64_t maze_count;
+    uint64_t index_offset;
+    uint64_t reserved[5];
+};
+
+static_assert(sizeof(MazeArchiveHeader) == 64, "maze archive header must stay 64 bytes");
+static_assert(sizeof(MazeArchiveTrailer) == 64, "maze archive trailer must stay 64 bytes");
+
+/*
+* Appends mazes to a new or existing archive, from any number of threads at once.
+*
+* Walls are compressed on the calling thread and only reserving the record's place in the file
+* takes the lock, so generators appending in parallel compress in parallel. Positions in the
+* index can be reserved up front, so parallel appends keep a deterministic order.
+*
+* New records of an existing archive go after its old trailer. close() writes the whole index
+* and a trailer after them, so until then the old index is intact. If any reserved maze wasn't
+* written, close() cuts the file back to what it was instead of writing an index.
+*/
+class MazeArchiveWriter {
+    int fd;
+    std::mutex append_mutex;
+    // file size when opened, restored if the appended mazes are dropped
+    uint64_t original_size;
+    uint64_t end_offset;
+    std::vector<MazeArchiveEntry> entries;
+    bool closed;
+
+    // writes all bytes at the offset, throws std::runtime_error if it can't
+    void write_at(const void* data, size_t size, uint64_t offset);
+
+public:
+    /*
+    * Creates the archive, or opens an existing one to append to it.
+    * Throws std::runtime_error if the file can't be opened or is not an archive.
+    */
+    explicit MazeArchiveWriter(const std::string& filename);
+
+    // closes the archive if close() wasn't called, errors are lost
+    ~MazeArchiveWriter();
+
+    MazeArchiveWriter(const MazeArchiveWriter&) = delete;
+    MazeArchiveWriter& operator=(const MazeArchiveWriter&) = delete;
+
+    /*
+    * Reserves the next position in the archive for a maze appended later with append(maze, position).
+    * Throws std::runtime_error if the archive is closed.
+    */
+    size_t reserve();
+
+    /*
+    * Compresses and appends a maze at the next position, safe to call from several threads at once.
+    * Throws std::runtime_error if the record can't be written.
+    * @return position of the maze in the archive
+    */
+    size_t append(const Maze& maze);
+
+    /*
+    * Compresses and appends a maze at a position from reserve(), safe to call from several threads
+    * at once. Throws std::runtime_error if the position isn't reserved or the record can't be written.
+    */
+    void append(const Maze& maze, size_t position);
+
+    // returns number of mazes in the archive, appended ones included
+    size_t get_maze_count();
+
+    /*
+    * Writes the index and closes the file, no more mazes can be appended.
+    * Throws std::runtime_error if the index can't be written, or if a reserved maze wasn't
+    * written, in which case the file is cut back to what it was when opened.
+    */
+    void close();
+};
+
+/*
+* Read-only view of an archive, mapped into memory. Decoding is safe from several threads at once.
+*/
+class MazeArchive {
+    MappedFile file;
+    const MazeArchiveEntry* entries;
+    size_t maze_count;
+
+    // returns the checked header of a record
+    const MazeFileHeader& get_record_header(size_t i) const;
+
+public:
+    /*
+    * Maps the archive and reads its index.
+    * Throws std::runtime_error if the file can't be mapped or is not a complete archive.
+    */
+    explicit MazeArchive(const std::string& filename);
+
+    size_t get_maze_count() const;
+
+    /*
+    * Decodes one maze, without a path.
+    * Throws std::out_of_range if there is no maze i, std::runtime_error if its record is invalid.
+    */
+    Maze get_maze(size_t i) const;
+
+    // returns bytes of coded walls of maze i
+    uint64_t get_compressed_size(size_t i) const;
+
+    // returns bytes the walls of maze i take uncompressed, as packed wall words
+    uint64_t get_raw_size(size_t i) const;
+};
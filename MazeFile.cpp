@@ -0,0 +1,133 @@
+#include "MazeFile.h"
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "Maze.h"
+#include "WallGrid.h"
+
+using namespace std;
+
+const char MAZE_FILE_MAGIC[8] = {'M', 'A', 'Z', 'E', 'F', 'I', 'L', 'E'};
+const uint32_t MAZE_FILE_VERSION = 1;
+
+MazeFileHeader make_maze_file_header(int width, int height) {
+    MazeFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MAZE_FILE_MAGIC, sizeof(header.magic));
+    header.version = MAZE_FILE_VERSION;
+    header.header_size = sizeof(MazeFileHeader);
+    header.width = width;
+    header.height = height;
+    header.end_row = height - 1;
+    header.end_col = width - 1;
+    header.wall_word_count = WallGrid::get_wall_word_count(height, width);
+    return header;
+}
+
+MappedFile::MappedFile(const string& filename) : data(nullptr), size(0) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw runtime_error("Could not open " + filename);
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+        ::close(fd);
+        throw runtime_error("Could not read size of " + filename);
+    }
+    size = file_stat.st_size;
+
+    // private copy-on-write mapping, pages are only read from disk when touched
+    data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        data = nullptr;
+        throw runtime_error("Could not map " + filename);
+    }
+}
+
+MappedFile::~MappedFile() {
+    if (data) {
+        munmap(data, size);
+    }
+}
+
+void* MappedFile::get_data() const {
+    return data;
+}
+
+size_t MappedFile::get_size() const {
+    return size;
+}
+
+void validate_maze_file_header(const MazeFileHeader& header) {
+    if (memcmp(header.magic, MAZE_FILE_MAGIC, sizeof(header.magic)) != 0) {
+        throw runtime_error("Not a maze file");
+    }
+    if (header.version != MAZE_FILE_VERSION || header.header_size != sizeof(MazeFileHeader)) {
+        throw runtime_error("Unsupported maze file version " + to_string(header.version));
+    }
+    if (header.width <= 0 || header.height <= 0
+        || header.wall_word_count != WallGrid::get_wall_word_count(header.height, header.width)) {
+        throw runtime_error("Maze file has an invalid size");
+    }
+    if (header.start_row < 0 || header.start_row >= header.height || header.start_col < 0 || header.start_col >= header.width
+        || header.end_row < 0 || header.end_row >= header.height || header.end_col < 0 || header.end_col >= header.width) {
+        throw runtime_error("Maze file has start or end outside of the maze");
+    }
+    if (header.generator >= get_generator_names().size()) {
+        throw runtime_error("Maze file has unknown generator " + to_string(header.generator));
+    }
+}
+
+const MazeFileHeader& validate_maze_file(const MappedFile& file) {
+    if (file.get_size() < sizeof(MazeFileHeader)) {
+        throw runtime_error("Maze file is too small for a header");
+    }
+    const MazeFileHeader& header = *static_cast<const MazeFileHeader*>(file.get_data());
+    validate_maze_file_header(header);
+    if (file.get_size() < sizeof(MazeFileHeader) + header.wall_word_count * sizeof(uint64_t)) {
+        throw runtime_error("Maze file is truncated");
+    }
+    return header;
+}
+
+MazeFileWriter::MazeFileWriter(const string& filename, const MazeFileHeader& h)
+    : out(filename, ios::binary), header(h), word(0), cells_in_word(0), rows_written(0) {
+    if (!out) {
+        throw runtime_error("Could not create " + filename);
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+void MazeFileWriter::write_row(const vector<uint8_t>& walls) {
+    for (uint8_t cell : walls) {
+        word |= static_cast<uint64_t>(cell & 3) << (2 * cells_in_word);
+        if (++cells_in_word == 32) {
+            out.write(reinterpret_cast<const char*>(&word), sizeof(word));
+            word = 0;
+            cells_in_word = 0;
+        }
+    }
+    rows_written++;
+}
+
+void MazeFileWriter::close() {
+    if (rows_written != static_cast<uint64_t>(header.height)) {
+        throw runtime_error("Maze file closed after " + to_string(rows_written) + " of "
+            + to_string(header.height) + " rows");
+    }
+    if (cells_in_word > 0) {
+        // unused bits are set, like the padding of a freshly built WallGrid
+        word |= ~uint64_t(0) << (2 * cells_in_word);
+        out.write(reinterpret_cast<const char*>(&word), sizeof(word));
+        cells_in_word = 0;
+    }
+    out.close();
+    if (!out) {
+        throw runtime_error("Could not write maze file");
+    }
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/*
+* Binary maze file, version 1.
+*
+* A 64 byte MazeFileHeader followed by wall_word_count little-endian 64 bit words holding the
+* packed wall bits in the layout of WallGrid::get_wall_words(). The words start at a multiple
+* of 8 bytes, so a mapped file can be used as a WallGrid without copying.
+*/
+struct MazeFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    int32_t width;
+    int32_t height;
+    int32_t start_row;
+    int32_t start_col;
+    int32_t end_row;
+    int32_t end_col;
+    uint64_t seed;
+    uint32_t generator;
+    uint32_t reserved;
+    uint64_t wall_word_count;
+};
+
+static_assert(sizeof(MazeFileHeader) == 64, "maze file header must stay 64 bytes");
+
+extern const char MAZE_FILE_MAGIC[8];
+extern const uint32_t MAZE_FILE_VERSION;
+
+/*
+* Returns a header with magic, version and sizes filled in for a maze of that size.
+*/
+MazeFileHeader make_maze_file_header(int width, int height);
+
+/*
+* Read-only view of a whole file mapped into memory. Pages are mapped privately, so writes
+* through data() stay local to the process and never reach the file.
+*/
+class MappedFile {
+    void* data;
+    size_t size;
+
+public:
+    /*
+    * Maps the file into memory.
+    * Throws std::runtime_error if the file can't be opened or mapped.
+    */
+    explicit MappedFile(const std::string& filename);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    void* get_data() const;
+    size_t get_size() const;
+};
+
+/*
+* Checks magic, version, size and start/end locations of a header.
+* Throws std::runtime_error if one of them is invalid.
+*/
+void validate_maze_file_header(const MazeFileHeader& header);
+
+/*
+* Checks that the mapped bytes start with a valid header and hold all of its wall words.
+* Throws std::runtime_error if they don't.
+*/
+const MazeFileHeader& validate_maze_file(const MappedFile& file);
+
+/*
+* Writes a maze file one row of cells at a time, e.g. from an EllerGenerator, so mazes larger
+* than memory can be saved. Only one word of wall bits is buffered.
+*/
+class MazeFileWriter {
+    std::ofstream out;
+    MazeFileHeader header;
+    uint64_t word;
+    int cells_in_word;
+    uint64_t rows_written;
+
+public:
+    /*
+    * Creates the file and writes the header.
+    * Throws std::runtime_error if the file can't be created.
+    */
+    MazeFileWriter(const std::string& filename, const MazeFileHeader& header);
+
+    /*
+    * Appends a row of cells, each a combination of EllerGenerator::EAST_WALL and SOUTH_WALL.
+    */
+    void write_row(const std::vector<uint8_t>& walls);
+
+    /*
+    * Flushes the last word and closes the file.
+    * Throws std::runtime_error if not every row was written or the write failed.
+    */
+    void close();
+};
@@ -0,0 +1,372 @@
+#include "MazeRenderer.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <ncurses.h>
+
+using namespace std;
+
+static const int PATH_COLOR = 1;
+static const int VISIT_COLOR = 2;
+// batches of visits drawn per frame at most, so a fast solver can't hold up a frame
+static const int MAX_VISIT_BATCHES_PER_FRAME = 64;
+
+MazeRenderer::MazeRenderer(Maze& m, int fps, int cells, double max_seconds)
+    : maze(m), raw_height(2 * m.get_height() + 1), raw_width(2 * m.get_width() + 1),
+      frames_per_second(max(1, fps)), cells_per_second(max(1, cells)), max_animation_seconds(max_seconds),
+      view_top(0), view_left(0), scale(1), view_rows(1), view_cols(1), follow_path(true),
+      next_cell(m.get_path().begin()), previous_cell(-1, -1), revealed(0), visits(nullptr), visit_count(0) {}
+
+void MazeRenderer::resize() {
+    int rows, cols;
+    getmaxyx(stdscr, rows, cols);
+    // the first line is the status line
+    view_rows = max(1, rows - 1);
+    view_cols = max(1, cols);
+    frame.assign(static_cast<size_t>(view_rows) * view_cols, Glyph::EMPTY);
+    shown.assign(frame.size(), Glyph::UNKNOWN);
+    clamp_view();
+}
+
+void MazeRenderer::clamp_view() {
+    int max_top = max(0, raw_height - view_rows * scale);
+    int max_left = max(0, raw_width - view_cols * scale);
+    view_top = min(max(view_top, 0), max_top);
+    view_left = min(max(view_left, 0), max_left);
+}
+
+void MazeRenderer::center_on(int y, int x) {
+    view_top = y - view_rows * scale / 2;
+    view_left = x - view_cols * scale / 2;
+    clamp_view();
+}
+
+void MazeRenderer::draw_frame() {
+    // one raw cell sampled per character, the top left one of its block
+    for (int row = 0; row < view_rows; ++row) {
+        int y = view_top + row * scale;
+        for (int col = 0; col < view_cols; ++col) {
+            int x = view_left + col * scale;
+            Glyph glyph = Glyph::EMPTY;
+            if (y < raw_height && x < raw_width) {
+                switch (maze.get_raw(y, x)) {
+                    case Maze::GridValue::WALL:
+                        glyph = Glyph::WALL;
+                        break;
+                    case Maze::GridValue::PATH:
+                        glyph = Glyph::PATH;
+                        break;
+                    case Maze::GridValue::EMPTY:
+                        break;
+                }
+            }
+            frame[static_cast<size_t>(row) * view_cols + col] = glyph;
+        }
+    }
+
+    // visits and the path are drawn over the walls, so they stay visible when zoomed out. Visits
+    // are sampled too, one cell per character: the first one whose raw coordinate is in its block
+    if (visit_count > 0) {
+        int width = maze.get_width();
+        for (int row = 0; row < view_rows; ++row) {
+            int y = view_top + row * scale;
+            if ((y | 1) >= y + scale || y / 2 >= maze.get_height()) {
+                continue;
+            }
+            for (int col = 0; col < view_cols; ++col) {
+                int x = view_left + col * scale;
+                if ((x | 1) >= x + scale || x / 2 >= width) {
+                    continue;
+                }
+                size_t index = static_cast<size_t>(y / 2) * width + x / 2;
+                if (visited_cells[index / 64] >> (index % 64) & 1) {
+                    frame[static_cast<size_t>(row) * view_cols + col] = Glyph::VISITED;
+                }
+            }
+        }
+    }
+    if (revealed == 0) {
+        return;
+    }
+    // only the chunks of the path in view are replayed, not the path from its start
+    int view_bottom = view_top + view_rows * scale;
+    int view_right = view_left + view_cols * scale;
+    for (size_t chunk = 0; chunk < path_chunks.size(); ++chunk) {
+        const PathChunk& run = path_chunks[chunk];
+        if (run.bottom < view_top || run.top >= view_bottom || run.right < view_left || run.left >= view_right) {
+            continue;
+        }
+        pair<int,int> previous = run.previous;
+        auto cell = run.first;
+        size_t count = min(PATH_CHUNK, revealed - chunk * PATH_CHUNK);
+        for (size_t i = 0; i < count; ++i, ++cell) {
+            draw_path_cell(previous, *cell);
+            previous = *cell;
+        }
+    }
+}
+
+void MazeRenderer::draw_raw(int y, int x, Glyph glyph) {
+    if (y < view_top || x < view_left) {
+        return;
+    }
+    int row = (y - view_top) / scale;
+    int col = (x - view_left) / scale;
+    if (row < view_rows && col < view_cols) {
+        Glyph& drawn = frame[static_cast<size_t>(row) * view_cols + col];
+        if (drawn != Glyph::PATH) {
+            drawn = glyph;
+        }
+    }
+}
+
+void MazeRenderer::draw_path_cell(pair<int,int> previous, pair<int,int> cell) {
+    int y = 2 * cell.first + 1;
+    int x = 2 * cell.second + 1;
+    if (previous.first != -1) {
+        // the passage is halfway between the raw coordinates of the two cells
+        draw_raw((y + 2 * previous.first + 1) / 2, (x + 2 * previous.second + 1) / 2, Glyph::PATH);
+    }
+    draw_raw(y, x, Glyph::PATH);
+}
+
+bool MazeRenderer::follow(pair<int,int> cell) {
+    if (!follow_path) {
+        return false;
+    }
+    int y = 2 * cell.first + 1;
+    int x = 2 * cell.second + 1;
+    bool in_view = y >= view_top && y < view_top + view_rows * scale
+        && x >= view_left && x < view_left + view_cols * scale;
+    if (in_view) {
+        return false;
+    }
+    center_on(y, x);
+    return true;
+}
+
+bool MazeRenderer::reveal(size_t count) {
+    size_t path_size = maze.get_path().size();
+    for (size_t i = 0; i < count && revealed < path_size; ++i) {
+        pair<int,int> cell = *next_cell;
+        int y = 2 * cell.first + 1;
+        int x = 2 * cell.second + 1;
+        if (revealed % PATH_CHUNK == 0) {
+            path_chunks.push_back(PathChunk{next_cell, previous_cell, y, x, y, x});
+        }
+        // the passage to the previous cell is drawn with the cell, it lies within one of them
+        PathChunk& run = path_chunks.back();
+        run.top = min(run.top, y - 1);
+        run.left = min(run.left, x - 1);
+        run.bottom = max(run.bottom, y + 1);
+        run.right = max(run.right, x + 1);
+        ++next_cell;
+        draw_path_cell(previous_cell, cell);
+        previous_cell = cell;
+        revealed++;
+    }
+    return revealed > 0 && follow(previous_cell);
+}
+
+bool MazeRenderer::show_visits(bool& drained) {
+    // everything queued since the last frame is drawn at once
+    int width = maze.get_width();
+    uint64_t previous_count = visit_count;
+    size_t last_visit = 0;
+    drained = false;
+    for (int batch = 0; batch < MAX_VISIT_BATCHES_PER_FRAME; ++batch) {
+        size_t count = visits->pop(visit_batch.data(), visit_batch.size());
+        for (size_t i = 0; i < count; ++i) {
+            size_t index = visit_batch[i];
+            visited_cells[index / 64] |= uint64_t(1) << (index % 64);
+            draw_raw(2 * (index / width) + 1, 2 * (index % width) + 1, Glyph::VISITED);
+        }
+        visit_count += count;
+        if (count > 0) {
+            last_visit = visit_batch[count - 1];
+        }
+        if (count < visit_batch.size()) {
+            drained = true;
+            break;
+        }
+    }
+    return visit_count > previous_count && follow(make_pair(last_visit / width, last_visit % width));
+}
+
+size_t MazeRenderer::get_cells_per_frame() const {
+    size_t path_size = maze.get_path().size();
+    double frame_budget = max_animation_seconds * frames_per_second;
+    return max<size_t>(1, max<size_t>(cells_per_second / frames_per_second,
+        static_cast<size_t>(ceil(path_size / frame_budget))));
+}
+
+bool MazeRenderer::handle_key(int key, bool& redraw) {
+    int vertical_step = max(1, view_rows / 4) * scale;
+    int horizontal_step = max(1, view_cols / 4) * scale;
+
+    switch (key) {
+        case 'q':
+        case 'Q':
+            return false;
+        case KEY_UP:
+        case 'k':
+            view_top -= vertical_step;
+            follow_path = false;
+            break;
+        case KEY_DOWN:
+        case 'j':
+            view_top += vertical_step;
+            follow_path = false;
+            break;
+        case KEY_LEFT:
+        case 'h':
+            view_left -= horizontal_step;
+            follow_path = false;
+            break;
+        case KEY_RIGHT:
+        case 'l':
+            view_left += horizontal_step;
+            follow_path = false;
+            break;
+        case '+':
+        case '=':
+            if (scale > 1) {
+                int y = view_top + view_rows * scale / 2;
+                int x = view_left + view_cols * scale / 2;
+                scale /= 2;
+                center_on(y, x);
+            }
+            break;
+        case '-':
+            if (raw_height > view_rows * scale || raw_width > view_cols * scale) {
+                int y = view_top + view_rows * scale / 2;
+                int x = view_left + view_cols * scale / 2;
+                scale *= 2;
+                center_on(y, x);
+            }
+            break;
+        case 'f':
+            scale = 1;
+            while (raw_height > view_rows * scale || raw_width > view_cols * scale) {
+                scale *= 2;
+            }
+            view_top = 0;
+            view_left = 0;
+            break;
+        case ' ':
+            if (!visits) {
+                reveal(maze.get_path().size());
+            }
+            break;
+        case KEY_RESIZE:
+            resize();
+            break;
+        default:
+            return true;
+    }
+    clamp_view();
+    redraw = true;
+    return true;
+}
+
+void MazeRenderer::present() {
+    if (visits) {
+        mvprintw(0, 0, "%dx%d maze  zoom 1:%d  solving: %llu visited, %llu dropped  arrows/hjkl scroll  +/- zoom  f fit  q quit",
+            maze.get_width(), maze.get_height(), scale, static_cast<unsigned long long>(visit_count),
+            static_cast<unsigned long long>(visits->get_dropped()));
+    } else {
+        mvprintw(0, 0, "%dx%d maze  zoom 1:%d  path %zu/%zu  arrows/hjkl scroll  +/- zoom  f fit  space finish  q quit",
+            maze.get_width(), maze.get_height(), scale, revealed, maze.get_path().size());
+    }
+    clrtoeol();
+
+    for (size_t i = 0; i < frame.size(); ++i) {
+        if (frame[i] == shown[i]) {
+            continue;
+        }
+        chtype ch = ' ';
+        if (frame[i] == Glyph::WALL) {
+            ch = ACS_BLOCK;
+        } else if (frame[i] == Glyph::PATH) {
+            ch = ACS_BLOCK | COLOR_PAIR(PATH_COLOR);
+        } else if (frame[i] == Glyph::VISITED) {
+            ch = ACS_BLOCK | COLOR_PAIR(VISIT_COLOR);
+        }
+        mvaddch(1 + i / view_cols, i % view_cols, ch);
+        shown[i] = frame[i];
+    }
+    refresh();
+}
+
+void MazeRenderer::run() {
+    initscr();
+    noecho();
+    cbreak();
+    keypad(stdscr, TRUE);
+    curs_set(0);
+    start_color();
+    init_pair(PATH_COLOR, COLOR_RED, COLOR_BLUE);
+    init_pair(VISIT_COLOR, COLOR_YELLOW, COLOR_BLACK);
+
+    resize();
+    draw_frame();
+    present();
+
+    size_t path_size = visits ? 0 : maze.get_path().size();
+    size_t cells_per_frame = visits ? 0 : get_cells_per_frame();
+    auto frame_period = chrono::duration<double>(1.0 / frames_per_second);
+
+    bool running = true;
+    while (running) {
+        auto frame_start = chrono::steady_clock::now();
+        bool animating = visits || revealed < path_size;
+        bool redraw = false;
+
+        // wait for a key once the animation is done, then take every key that is queued
+        timeout(animating ? 0 : -1);
+        for (int key = getch(); key != ERR; key = getch()) {
+            if (!handle_key(key, redraw)) {
+                running = false;
+                break;
+            }
+            timeout(0);
+        }
+
+        if (visits) {
+            // closed is read before draining, so the visits queued before it are all drawn
+            bool solved = visits->is_closed();
+            if (solved && visits->is_cancelled()) {
+                // the solve failed, there is no path to show
+                break;
+            }
+            bool drained = false;
+            redraw |= show_visits(drained);
+            if (solved && drained) {
+                visits = nullptr;
+                next_cell = maze.get_path().begin();
+                path_size = maze.get_path().size();
+                cells_per_frame = get_cells_per_frame();
+            }
+        } else if (animating) {
+            redraw |= reveal(cells_per_frame);
+        }
+        if (redraw) {
+            draw_frame();
+        }
+        present();
+
+        if (animating) {
+            this_thread::sleep_until(frame_start + chrono::duration_cast<chrono::steady_clock::duration>(frame_period));
+        }
+    }
+    endwin();
+}
+
+void MazeRenderer::watch(VisitQueue& queue) {
+    visits = &queue;
+    visited_cells.assign((static_cast<size_t>(maze.get_height()) * maze.get_width() + 63) / 64, 0);
+    visit_count = 0;
+    visit_batch.resize(VISIT_BATCH);
+    run();
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Maze.h"
+#include "VisitQueue.h"
+
+/*
+* Frame-buffered ncurses view of a Maze and its Path.
+*
+* Every frame is drawn into an off-screen buffer the size of the terminal, and only the
+* characters that differ from the previous frame are handed to ncurses. The viewport covers
+* part of the raw grid (walls included) and can be scrolled and zoomed out, one character then
+* samples a square block of raw cells, so huge mazes draw in time proportional to the screen.
+*
+* The path is revealed a batch of cells per frame at a fixed frame rate. Batches grow with the
+* path length so the whole animation takes at most max_animation_seconds.
+*
+* watch() shows a solve running on another thread live: every frame draws the cells visited
+* since the last one, read from a VisitQueue, and the path is animated once the solve is done.
+* Rendering never slows the solver down, the queue drops visits if the renderer falls behind.
+*
+* Keys: arrows or hjkl scroll, + and - zoom, f fits the maze, space finishes the animation,
+* q quits.
+*/
+class MazeRenderer {
+    // what one character of the screen shows, UNKNOWN forces a redraw
+    enum class Glyph : uint8_t { EMPTY, WALL, PATH, VISITED, UNKNOWN };
+
+    // visits taken from the queue at once
+    static const size_t VISIT_BATCH = 1 << 14;
+    // revealed path cells per chunk, a redraw replays only the chunks in view
+    static const size_t PATH_CHUNK = 1 << 10;
+
+    // a run of revealed path cells and the raw rectangle they are drawn in
+    struct PathChunk {
+        Path::Iterator first;
+        std::pair<int,int> previous;
+        int top;
+        int left;
+        int bottom;
+        int right;
+    };
+
+    Maze& maze;
+    int raw_height;
+    int raw_width;
+
+    int frames_per_second;
+    int cells_per_second;
+    double max_animation_seconds;
+
+    // viewport: raw coordinate of the top left character, raw cells per character side
+    int view_top;
+    int view_left;
+    int scale;
+    int view_rows;
+    int view_cols;
+    bool follow_path;
+
+    std::vector<Glyph> frame;
+    std::vector<Glyph> shown;
+
+    Path::Iterator next_cell;
+    std::pair<int,int> previous_cell;
+    size_t revealed;
+    std::vector<PathChunk> path_chunks;
+
+    // queue of the solve being watched, nullptr once it is done. The path must not be read
+    // before then, the solver thread sets it
+    VisitQueue* visits;
+    // one bit per cell, like the steps of a Path
+    std::vector<uint64_t> visited_cells;
+    uint64_t visit_count;
+    std::vector<uint64_t> visit_batch;
+
+    // reads the terminal size and resizes the buffers, forcing a full redraw
+    void resize();
+
+    // keeps the viewport inside the maze
+    void clamp_view();
+
+    // centers the viewport on a raw coordinate
+    void center_on(int y, int x);
+
+    // redraws the whole buffer from the maze, the sampled visits and the revealed part of the path
+    void draw_frame();
+
+    // draws a raw coordinate into the buffer if it is in view, the path stays on top
+    void draw_raw(int y, int x, Glyph glyph);
+
+    // draws a cell of the path and the passage from the previous cell
+    void draw_path_cell(std::pair<int,int> previous, std::pair<int,int> cell);
+
+    // moves the viewport to the cell if it is followed and out of view, returns true if it moved
+    bool follow(std::pair<int,int> cell);
+
+    // reveals up to count more cells of the path, returns true if the viewport moved
+    bool reveal(size_t count);
+
+    /*
+    * Draws the cells visited since the last frame.
+    * @param drained set to true if the queue was emptied
+    * @return true if the viewport moved
+    */
+    bool show_visits(bool& drained);
+
+    // returns path cells revealed per frame, enough for cells_per_second and max_animation_seconds
+    size_t get_cells_per_frame() const;
+
+    // handles a key, returns false to quit
+    bool handle_key(int key, bool& redraw);
+
+    // writes the changed characters of the buffer and the status line to the screen
+    void present();
+
+public:
+    /*
+    * @param maze maze to show, its path is animated
+    * @param frames_per_second target frame rate of the animation
+    * @param cells_per_second path cells revealed per second unless the path is too long for
+    *        max_animation_seconds
+    */
+    MazeRenderer(Maze& maze, int frames_per_second = 60, int cells_per_second = 700,
+        double max_animation_seconds = 5);
+
+    // shows the maze until q is pressed
+    void run();
+
+    /*
+    * Shows the visits of a solve on another thread as they are queued, then animates the path,
+    * until q is pressed. The solver thread must set the path on the maze before it closes the
+    * queue, and must not change walls meanwhile. Returns without showing a path once the queue
+    * is cancelled.
+    */
+    void watch(VisitQueue& visits);
+};
@@ -0,0 +1,166 @@
+#include "ParallelBFSSolver.h"
+#include "Instrument.h"
+#include "VisitQueue.h"
+#include <algorithm>
+#include <thread>
+
+using namespace std;
+
+using Side = Maze::Side;
+
+// levels with fewer cells than this are expanded on the calling thread
+static const size_t MIN_PARALLEL_FRONTIER = 4096;
+
+// chunks per worker, more than one so fast workers can steal from slow ones
+static const size_t CHUNKS_PER_THREAD = 4;
+
+static const Side SIDES[] = {Side::TOP, Side::RIGHT, Side::BOTTOM, Side::LEFT};
+
+ParallelBFSSolver::ParallelBFSSolver(int threads) : thread_count(threads), cell_count(0) {
+    if (thread_count <= 0) {
+        thread_count = max(1u, thread::hardware_concurrency());
+    }
+}
+
+string ParallelBFSSolver::get_name() const {
+    return "pbfs";
+}
+
+int ParallelBFSSolver::get_thread_count() const {
+    return thread_count;
+}
+
+void ParallelBFSSolver::prepare(const Maze& maze) {
+    size_t cells = static_cast<size_t>(maze.get_height()) * maze.get_width();
+    size_t word_count = (cells + 63) / 64;
+    if (cells != cell_count) {
+        cell_count = cells;
+        visited = make_unique<atomic<uint64_t>[]>(word_count);
+        level_mod3.resize(cells);
+        MAZE_COUNT_ALLOCATION(word_count * sizeof(uint64_t) + cells);
+    }
+    for (size_t i = 0; i < word_count; ++i) {
+        visited[i].store(0, memory_order_relaxed);
+    }
+
+    if (!pool && thread_count > 1) {
+        pool = make_unique<ThreadPool>(thread_count);
+    }
+    next_frontiers.resize(thread_count);
+    frontier.clear();
+}
+
+bool ParallelBFSSolver::is_visited(size_t index) const {
+    return (visited[index >> 6].load(memory_order_relaxed) >> (index & 63)) & 1;
+}
+
+void ParallelBFSSolver::expand(const Maze& maze, size_t begin, size_t end, uint8_t next_level, int worker) {
+    int width = maze.get_width();
+    vector<size_t>& next = next_frontiers[worker];
+
+    for (size_t i = begin; i < end; ++i) {
+        size_t index = frontier[i];
+        int row = index / width;
+        int col = index % width;
+
+        for (Side side : SIDES) {
+            if (!maze.is_passage_open(row, col, side)) {
+                continue;
+            }
+            size_t neighbor = index + maze.get_index_offset(side);
+            uint64_t bit = uint64_t(1) << (neighbor & 63);
+            atomic<uint64_t>& word = visited[neighbor >> 6];
+
+            // cheap check first, only the fetch_or decides who owns the cell
+            if (word.load(memory_order_relaxed) & bit) {
+                continue;
+            }
+            if (word.fetch_or(bit, memory_order_relaxed) & bit) {
+                continue;
+            }
+            level_mod3[neighbor] = next_level;
+            next.push_back(neighbor);
+        }
+    }
+}
+
+Path ParallelBFSSolver::solve(const Maze& maze, pair<int,int> start, pair<int,int> end) {
+    MAZE_PHASE(Phase::SOLVE);
+    nodes_expanded = 0;
+    prepare(maze);
+
+    size_t start_index = get_index(maze, start);
+    size_t end_index = get_index(maze, end);
+    visited[start_index >> 6].fetch_or(uint64_t(1) << (start_index & 63));
+    level_mod3[start_index] = 0;
+    frontier.push_back(start_index);
+    MAZE_COUNT_VISIT(start_index);
+    publish_visit(start_index);
+    uint32_t level = 0;
+
+    while (!frontier.empty() && !is_visited(end_index)) {
+        nodes_expanded += frontier.size();
+        uint8_t next_level = (level + 1) % 3;
+
+        if (!pool || frontier.size() < MIN_PARALLEL_FRONTIER) {
+            expand(maze, 0, frontier.size(), next_level, 0);
+        } else {
+            size_t chunk_count = thread_count * CHUNKS_PER_THREAD;
+            size_t chunk_size = (frontier.size() + chunk_count - 1) / chunk_count;
+            for (size_t begin = 0; begin < frontier.size(); begin += chunk_size) {
+                size_t end = min(begin + chunk_size, frontier.size());
+                pool->submit([this, &maze, begin, end, next_level](int worker) {
+                    expand(maze, begin, end, next_level, worker);
+                });
+            }
+            pool->wait();
+        }
+
+        // workers don't count, their cells are counted here on the calling thread
+        frontier.clear();
+        for (auto& next : next_frontiers) {
+            frontier.insert(frontier.end(), next.begin(), next.end());
+            next.clear();
+        }
+#ifdef MAZE_INSTRUMENT
+        for (size_t index : frontier) {
+            MAZE_COUNT_VISIT(index);
+        }
+#endif
+        if (VisitQueue* visits = VisitQueue::get_current()) {
+            for (size_t index : frontier) {
+                visits->push(index);
+            }
+        }
+        MAZE_TRACK_FRONTIER(frontier.size());
+        level++;
+    }
+
+    if (!is_visited(end_index)) {
+        return Path();
+    }
+    nodes_expanded++;
+
+    // walk back through the levels, level - 1 is the only neighbor level with (level - 1) % 3
+    Path path(end);
+    size_t index = end_index;
+
+    for (uint32_t step = level; step > 0; --step) {
+        uint8_t previous_level = (step - 1) % 3;
+        pair<int,int> cell = get_cell(maze, index);
+        for (Side side : SIDES) {
+            if (!maze.is_passage_open(cell.first, cell.second, side)) {
+                continue;
+            }
+            size_t neighbor = index + maze.get_index_offset(side);
+            if (is_visited(neighbor) && level_mod3[neighbor] == previous_level) {
+                index = neighbor;
+                break;
+            }
+        }
+        path.add(get_cell(maze, index));
+    }
+
+    path.reverse();
+    return path;
+}
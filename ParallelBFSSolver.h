@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Solver.h"
+#include "ThreadPool.h"
+
+/*
+* Level-synchronous breadth first search over several threads, for single huge mazes.
+*
+* Each level the frontier is split into chunks that the workers of a ThreadPool expand at once.
+* Visited cells are bits in a flat atomic array, a cell belongs to the worker whose fetch_or sets
+* its bit, and every worker collects the cells it wins in its own next-frontier buffer. Levels
+* with a small frontier, common in perfect mazes, are expanded on the calling thread since
+* handing them out would cost more than the work.
+*
+* Which worker wins a cell is not deterministic, so the path is not read from parents. The level
+* of each cell is kept modulo 3 and the path is traced back through the levels in a fixed side
+* order instead, which makes the Path independent of the thread count. On perfect mazes it is the
+* same Path BFSSolver finds, on braided mazes it is a shortest path of the same length.
+*/
+class ParallelBFSSolver : public Solver {
+    int thread_count;
+    std::unique_ptr<ThreadPool> pool;
+    size_t cell_count;
+    std::unique_ptr<std::atomic<uint64_t>[]> visited;
+    std::vector<uint8_t> level_mod3;
+    std::vector<size_t> frontier;
+    std::vector<std::vector<size_t>> next_frontiers;
+
+    // resizes and clears the visited bits for a maze of that size
+    void prepare(const Maze& maze);
+
+    bool is_visited(size_t index) const;
+
+    // expands frontier[begin, end) into the next-frontier buffer of the worker
+    void expand(const Maze& maze, size_t begin, size_t end, uint8_t next_level, int worker);
+
+public:
+    /*
+    * @param thread_count number of worker threads, 0 uses one per hardware thread
+    */
+    explicit ParallelBFSSolver(int thread_count = 0);
+
+    std::string get_name() const override;
+    Path solve(const Maze& maze, std::pair<int,int> start, std::pair<int,int> end) override;
+
+    int get_thread_count() const;
+};
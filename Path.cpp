@@ -1,19 +1,193 @@
 #include "Path.h"
+#include <algorithm>
+#include <assert.h>
+#include <cstdlib>
 
 using namespace std;
 
-vector<pair<int,int>> Path::get_path_coordinates(){
-    return path_coordinates;
+static const int STEPS_PER_WORD = 32;
+
+// row and col change of each Step
+static const int STEP_ROW[] = {-1, 0, 1, 0};
+static const int STEP_COL[] = {0, -1, 0, 1};
+
+Path::Iterator::Iterator(const Path* p, size_t s, pair<int,int> c) : path(p), step(s), cell(c) {}
+
+Path::Iterator::reference Path::Iterator::operator*() const {
+    return cell;
+}
+
+Path::Iterator::pointer Path::Iterator::operator->() const {
+    return &cell;
+}
+
+Path::Iterator& Path::Iterator::operator++() {
+    if (step < path->step_count) {
+        cell = get_neighbor(cell, path->get_step(step));
+    }
+    step++;
+    return *this;
+}
+
+Path::Iterator Path::Iterator::operator++(int) {
+    Iterator previous = *this;
+    ++*this;
+    return previous;
+}
+
+bool Path::Iterator::operator==(const Iterator& other) const {
+    return path == other.path && step == other.step;
+}
+
+bool Path::Iterator::operator!=(const Iterator& other) const {
+    return !(*this == other);
+}
+
+Path::Path() : start(-1, -1), last(-1, -1), step_count(0) {}
+
+Path::Path(pair<int,int> s) : start(s), last(s), step_count(0) {}
+
+Path::Path(const vector<pair<int,int>>& coordinates) : Path() {
+    for (auto cell : coordinates) {
+        add(cell);
+    }
+}
+
+Path::Path(Path&& other) noexcept
+    : start(other.start), last(other.last), step_count(other.step_count), steps(move(other.steps)) {
+    other = Path();
+}
+
+Path& Path::operator=(Path&& other) noexcept {
+    if (this != &other) {
+        start = other.start;
+        last = other.last;
+        step_count = other.step_count;
+        steps = move(other.steps);
+        other.start = other.last = make_pair(-1, -1);
+        other.step_count = 0;
+        other.steps.clear();
+    }
+    return *this;
+}
+
+size_t Path::size() const {
+    return start.first < 0 ? 0 : step_count + 1;
+}
+
+bool Path::empty() const {
+    return size() == 0;
+}
+
+pair<int,int> Path::get_start() const {
+    assert(!empty());
+    return start;
+}
+
+pair<int,int> Path::get_end() const {
+    assert(!empty());
+    return last;
+}
+
+Path::Step Path::get_step(size_t i) const {
+    assert(i < step_count);
+    return Step((steps[i / STEPS_PER_WORD] >> (2 * (i % STEPS_PER_WORD))) & 3);
+}
+
+void Path::set_step(size_t i, Step step) {
+    int shift = 2 * (i % STEPS_PER_WORD);
+    uint64_t& word = steps[i / STEPS_PER_WORD];
+    word = (word & ~(uint64_t(3) << shift)) | (uint64_t(step) << shift);
+}
+
+const vector<uint64_t>& Path::get_step_words() const {
+    return steps;
+}
+
+Path::Iterator Path::begin() const {
+    return Iterator(this, 0, start);
+}
+
+Path::Iterator Path::end() const {
+    return Iterator(this, size(), last);
+}
+
+pair<int,int> Path::get_neighbor(pair<int,int> cell, Step step) {
+    return make_pair(cell.first + STEP_ROW[int(step)], cell.second + STEP_COL[int(step)]);
 }
 
 void Path::add(pair<int,int> coordinate) {
-    path_coordinates.push_back(coordinate);
+    if (empty()) {
+        start = last = coordinate;
+        return;
+    }
+    int row_change = coordinate.first - last.first;
+    int col_change = coordinate.second - last.second;
+    assert(abs(row_change) + abs(col_change) == 1);
+
+    if (row_change != 0) {
+        add_step(row_change < 0 ? Step::UP : Step::DOWN);
+    } else {
+        add_step(col_change < 0 ? Step::LEFT : Step::RIGHT);
+    }
 }
 
 void Path::add(int row, int col) {
-    path_coordinates.push_back(make_pair(row,col));
+    add(make_pair(row, col));
+}
+
+void Path::add_step(Step step) {
+    assert(!empty());
+    if (step_count % STEPS_PER_WORD == 0) {
+        steps.push_back(0);
+    }
+    set_step(step_count++, step);
+    last = get_neighbor(last, step);
 }
 
-Path::Path() {}
+Path::Step Path::pop_step() {
+    assert(step_count > 0);
+    Step step = get_step(step_count - 1);
+    step_count--;
+    if (step_count % STEPS_PER_WORD == 0) {
+        steps.pop_back();
+    }
+    last = get_neighbor(last, Step((int(step) + 2) % 4));
+    return step;
+}
+
+void Path::append(const Path& other) {
+    if (other.empty()) {
+        return;
+    }
+    if (empty()) {
+        *this = other;
+        return;
+    }
+    assert(other.start == last);
+    steps.reserve((step_count + other.step_count + STEPS_PER_WORD - 1) / STEPS_PER_WORD);
+    for (size_t i = 0; i < other.step_count; ++i) {
+        add_step(other.get_step(i));
+    }
+}
 
-Path::Path(vector<pair<int,int>> coordinates) : path_coordinates(coordinates) {}
+void Path::reverse() {
+    if (step_count == 0) {
+        return;
+    }
+    // the steps run backwards and each one turns to the opposite direction
+    for (size_t i = 0, j = step_count - 1; i < j; ++i, --j) {
+        Step first = get_step(i);
+        set_step(i, Step((int(get_step(j)) + 2) % 4));
+        set_step(j, Step((int(first) + 2) % 4));
+    }
+    if (step_count % 2 == 1) {
+        size_t middle = step_count / 2;
+        set_step(middle, Step((int(get_step(middle)) + 2) % 4));
+    }
+    swap(start, last);
+}
+
+size_t Path::get_memory_usage() const {
+    return steps.capacity() * sizeof(uint64_t);
+}
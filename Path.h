@@ -1,35 +1,121 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
 #include <vector>
 
+/**
+ * A connected path of cells, stored as its start cell plus one 2 bit step per move.
+ *
+ * Steps are packed 32 to a word, so a path takes a quarter byte per cell instead of the 8 bytes
+ * of a (row,col) pair. Cells are recomputed while iterating, which costs O(1) memory per step.
+*/
 class Path {
-    std::vector<std::pair<int,int>> path_coordinates;
-
 public:
+    // direction of one step, in the order of Maze::Side so a Side casts straight to a Step
+    enum class Step : uint8_t { UP, LEFT, DOWN, RIGHT };
+
     /**
-     * Returns path coordinates as a vector of (row,col).
+     * Forward iterator over the (row,col) cells of a path, from start to end.
     */
-    std::vector<std::pair<int,int>> get_path_coordinates();
+    class Iterator {
+        const Path* path;
+        size_t step;
+        std::pair<int,int> cell;
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::pair<int,int>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const std::pair<int,int>*;
+        using reference = const std::pair<int,int>&;
+
+        Iterator(const Path* path, size_t step, std::pair<int,int> cell);
+
+        reference operator*() const;
+        pointer operator->() const;
+        Iterator& operator++();
+        Iterator operator++(int);
+        bool operator==(const Iterator& other) const;
+        bool operator!=(const Iterator& other) const;
+    };
 
     /**
-     * Add to coordinates, must be (row,col)
+     * Initialized a Path object without any cells.
     */
+    Path();
 
-   void add(std::pair<int,int> coordinate);
+    /**
+     * Initializes a Path object of the single start cell (row,col).
+    */
+    explicit Path(std::pair<int,int> start);
 
     /**
-        * Add to coordinates.
+     * Initializes a Path object with the passed in coordinates, each adjacent to the previous one.
     */
+    Path(const std::vector<std::pair<int,int>>& coordinates);
+
+    Path(const Path& other) = default;
+    Path(Path&& other) noexcept;
+    Path& operator=(const Path& other) = default;
+    Path& operator=(Path&& other) noexcept;
+
+    // number of cells, start and end included
+    size_t size() const;
+    bool empty() const;
 
-    void add(int x, int y);
+    // first and last cell, the path must not be empty
+    std::pair<int,int> get_start() const;
+    std::pair<int,int> get_end() const;
+
+    // direction of the move from cell i to cell i + 1
+    Step get_step(size_t i) const;
 
     /**
-     * Initialized a Path object with an empty vector of path coordinates.
+     * Returns the packed steps: step i is bits 2 * (i % 32) of word i / 32.
     */
-    Path();
+    const std::vector<uint64_t>& get_step_words() const;
+
+    Iterator begin() const;
+    Iterator end() const;
 
     /**
-     * Initializes a Path object with the passed in coordinates.
+     * Add to coordinates, must be (row,col). Starts the path if it is empty, else the cell
+     * must be adjacent to the end of the path.
     */
-    Path(std::vector<std::pair<int,int>> coordinates);
-};
\ No newline at end of file
+    void add(std::pair<int,int> coordinate);
+
+    /**
+     * Add to coordinates.
+    */
+    void add(int row, int col);
+
+    // moves the end of a non-empty path one cell in the direction
+    void add_step(Step step);
+
+    // removes the last step of a path with at least two cells and returns it
+    Step pop_step();
+
+    /**
+     * Appends a path that starts at the end of this one, the shared cell is kept once.
+    */
+    void append(const Path& other);
+
+    // turns the path around in place, the end becomes the start
+    void reverse();
+
+    // returns (row,col) of the cell one step away
+    static std::pair<int,int> get_neighbor(std::pair<int,int> cell, Step step);
+
+    // returns number of bytes used by the packed steps
+    size_t get_memory_usage() const;
+
+private:
+    std::pair<int,int> start;
+    std::pair<int,int> last;
+    size_t step_count;
+    std::vector<uint64_t> steps;
+
+    void set_step(size_t i, Step step);
+};
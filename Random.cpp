@@ -0,0 +1,52 @@
+#include "Random.h"
+#include <assert.h>
+#include <atomic>
+#include <chrono>
+#include <random>
+
+using namespace std;
+
+static uint64_t splitmix64(uint64_t& x) {
+    uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+static uint64_t rotate_left(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+Random::Random(uint64_t seed) {
+    for (auto& word : state) {
+        word = splitmix64(seed);
+    }
+}
+
+uint64_t Random::next() {
+    uint64_t result = rotate_left(state[1] * 5, 7) * 9;
+    uint64_t t = state[1] << 17;
+
+    state[2] ^= state[0];
+    state[3] ^= state[1];
+    state[1] ^= state[2];
+    state[0] ^= state[3];
+    state[2] ^= t;
+    state[3] = rotate_left(state[3], 45);
+
+    return result;
+}
+
+uint64_t Random::next_below(uint64_t bound) {
+    assert(bound > 0);
+    // Lemire's multiply and shift, the bias is below 2^-32 for the bounds used by mazes
+    return static_cast<uint64_t>((static_cast<unsigned __int128>(next()) * bound) >> 64);
+}
+
+uint64_t Random::make_seed() {
+    static atomic<uint64_t> counter{0};
+    uint64_t seed = random_device{}();
+    seed = (seed << 32) ^ chrono::steady_clock::now().time_since_epoch().count();
+    seed ^= counter.fetch_add(1) * 0x9e3779b97f4a7c15ULL;
+    return splitmix64(seed);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+* Fast pseudo random number generator (xoshiro256**), one instance per maze or thread.
+*
+* Unlike rand() it has no global state, so generators can run on several threads at once,
+* and a given seed always produces the same sequence on every platform.
+*/
+class Random {
+    uint64_t state[4];
+
+public:
+    /*
+    * Initializes the generator from a 64 bit seed, expanded to the full state with splitmix64.
+    */
+    explicit Random(uint64_t seed = 0);
+
+    // returns the next 64 random bits
+    uint64_t next();
+
+    /*
+    * Returns a uniformly distributed number in [0, bound).
+    * @param bound exclusive upper bound, must be > 0
+    */
+    uint64_t next_below(uint64_t bound);
+
+    /*
+    * Returns a seed that differs between calls, even within the same second or from
+    * several threads, for when no explicit seed is given.
+    */
+    static uint64_t make_seed();
+};
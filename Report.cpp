@@ -0,0 +1,75 @@
+#include "Report.h"
+
+using namespace std;
+
+bool parse_report_format(const string& name, ReportFormat& format) {
+    if (name == "csv") {
+        format = ReportFormat::CSV;
+    } else if (name == "json") {
+        format = ReportFormat::JSON;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// returns cells / seconds, or 0 if nothing was timed
+static double get_cells_per_second(const RunRecord& record, double seconds) {
+    if (seconds <= 0) {
+        return 0;
+    }
+    return static_cast<double>(record.width) * record.height / seconds;
+}
+
+static void write_csv(ostream& out, const vector<RunRecord>& records) {
+    out << "generator,solver,threads,layout,width,height,seed,generate_seconds,solve_seconds,"
+        << "generate_cells_per_second,solve_cells_per_second,path_length,nodes_expanded\n";
+    for (const auto& record : records) {
+        out << record.generator << ","
+            << record.solver << ","
+            << record.threads << ","
+            << record.layout << ","
+            << record.width << ","
+            << record.height << ","
+            << record.seed << ","
+            << record.generate_seconds << ","
+            << record.solve_seconds << ","
+            << get_cells_per_second(record, record.generate_seconds) << ","
+            << get_cells_per_second(record, record.solve_seconds) << ","
+            << record.path_length << ","
+            << record.nodes_expanded << "\n";
+    }
+}
+
+static void write_json(ostream& out, const vector<RunRecord>& records) {
+    out << "[";
+    for (size_t i = 0; i < records.size(); ++i) {
+        const RunRecord& record = records[i];
+        out << (i == 0 ? "\n" : ",\n")
+            << "  {\"generator\": \"" << record.generator << "\""
+            << ", \"solver\": \"" << record.solver << "\""
+            << ", \"threads\": " << record.threads
+            << ", \"layout\": \"" << record.layout << "\""
+            << ", \"width\": " << record.width
+            << ", \"height\": " << record.height
+            << ", \"seed\": " << record.seed
+            << ", \"generate_seconds\": " << record.generate_seconds
+            << ", \"solve_seconds\": " << record.solve_seconds
+            << ", \"generate_cells_per_second\": " << get_cells_per_second(record, record.generate_seconds)
+            << ", \"solve_cells_per_second\": " << get_cells_per_second(record, record.solve_seconds)
+            << ", \"path_length\": " << record.path_length
+            << ", \"nodes_expanded\": " << record.nodes_expanded << "}";
+    }
+    out << "\n]\n";
+}
+
+void write_report(ostream& out, const vector<RunRecord>& records, ReportFormat format) {
+    switch (format) {
+        case ReportFormat::CSV:
+            write_csv(out, records);
+            break;
+        case ReportFormat::JSON:
+            write_json(out, records);
+            break;
+    }
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+/*
+* Timings of one generate + solve run. Written out by the headless driver and the benchmark.
+*/
+struct RunRecord {
+    std::string generator;
+    std::string solver;
+    int threads = 1;
+    std::string layout = "row-major";
+    int width = 0;
+    int height = 0;
+    unsigned long long seed = 0;
+    double generate_seconds = 0;
+    double solve_seconds = 0;
+    size_t path_length = 0;
+    size_t nodes_expanded = 0;
+};
+
+enum class ReportFormat { CSV, JSON };
+
+/*
+* Parses "csv" or "json" into a ReportFormat.
+* @return false if the name is not a known format.
+*/
+bool parse_report_format(const std::string& name, ReportFormat& format);
+
+/*
+* Writes the records with derived cells/sec throughput to the stream.
+* CSV has a header line and one line per record, JSON is an array of objects.
+*/
+void write_report(std::ostream& out, const std::vector<RunRecord>& records, ReportFormat format);
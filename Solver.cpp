@@ -0,0 +1,329 @@
+#include "Solver.h"
+#include "WavefrontSolver.h"
+#include "LPAStarSolver.h"
+#include "ParallelBFSSolver.h"
+#include "Instrument.h"
+#include "MazeAlgorithms.h"
+#include <algorithm>
+#include <cstdlib>
+
+using namespace std;
+
+using Side = Maze::Side;
+
+// order in which neighbors are pushed, same as Maze::get_neighbors
+static const Side SIDES[] = {Side::TOP, Side::RIGHT, Side::BOTTOM, Side::LEFT};
+
+size_t Solver::get_index(const Maze& maze, pair<int,int> cell) {
+    return static_cast<size_t>(cell.first) * maze.get_width() + cell.second;
+}
+
+pair<int,int> Solver::get_cell(const Maze& maze, size_t index) {
+    return make_pair(index / maze.get_width(), index % maze.get_width());
+}
+
+size_t Solver::get_nodes_expanded() const {
+    return nodes_expanded;
+}
+
+string DFSSolver::get_name() const {
+    return "dfs";
+}
+
+Path DFSSolver::solve(const Maze& maze, pair<int,int> start, pair<int,int> end) {
+    return solve(maze, start, end, workspace);
+}
+
+Path DFSSolver::solve(const Maze& maze, pair<int,int> start, pair<int,int> end, SolverWorkspace& workspace) {
+    // from start index, dfs, keeping the parent of every pushed cell.
+    // the path is read back from the end cell through the parents.
+    MAZE_PHASE(Phase::SOLVE);
+    nodes_expanded = 0;
+    workspace.reset(maze.get_height(), maze.get_width());
+    vector<size_t>& s = workspace.stack;
+
+    size_t start_index = get_index(maze, start);
+    size_t end_index = get_index(maze, end);
+    s.push_back(start_index);
+
+    while (!s.empty()) {
+        size_t curr_index = s.back();
+        s.pop_back();
+
+        if (workspace.is_visited(curr_index)) {
+            continue;
+        }
+        workspace.mark_visited(curr_index);
+        nodes_expanded++;
+
+        pair<int,int> curr_cell = get_cell(maze, curr_index);
+
+        for (Side side : SIDES) {
+            if (!maze.is_passage_open(curr_cell.first, curr_cell.second, side)) {
+                continue;
+            }
+            size_t neighbor_index = curr_index + maze.get_index_offset(side);
+            if (workspace.is_visited(neighbor_index)) {
+                continue;
+            }
+            s.push_back(neighbor_index);
+            workspace.set_parent(neighbor_index, static_cast<uint8_t>(Maze::get_opposite_side(side)));
+        }
+        MAZE_TRACK_FRONTIER(s.size());
+    }
+
+    if (!workspace.is_visited(end_index)) {
+        return Path();
+    }
+
+    Path path;
+    append_parent_chain(maze, workspace, end_index, start_index, path);
+    path.reverse();
+    return path;
+}
+
+string BFSSolver::get_name() const {
+    return "bfs";
+}
+
+Path BFSSolver::solve(const Maze& maze, pair<int,int> start, pair<int,int> end) {
+    MAZE_PHASE(Phase::SOLVE);
+    nodes_expanded = 0;
+    workspace.reset(maze.get_height(), maze.get_width());
+
+    size_t start_index = get_index(maze, start);
+    size_t end_index = get_index(maze, end);
+    if (!breadth_first_search(maze, start_index, end_index, workspace, workspace.stack, nodes_expanded)) {
+        return Path();
+    }
+
+    Path path;
+    append_parent_chain(maze, workspace, end_index, start_index, path);
+    path.reverse();
+    return path;
+}
+
+string BidirectionalBFSSolver::get_name() const {
+    return "bibfs";
+}
+
+/*
+* Expands every cell of the current level of `self`, whose queue holds the level in [head, end).
+* Stops at the first passage into a cell visited by `other`, which gives a shortest path:
+* a cell seen by `other` in an earlier level would have met `self` earlier.
+* @return true if the searches met, with meet_self and meet_other set to the cells on each side.
+*/
+static bool expand_level(const Maze& maze, SolverWorkspace& self, const SolverWorkspace& other,
+    size_t& head, size_t& nodes_expanded, size_t& meet_self, size_t& meet_other) {
+    vector<size_t>& queue = self.stack;
+    size_t level_end = queue.size();
+    int width = maze.get_width();
+
+    while (head < level_end) {
+        size_t curr_index = queue[head++];
+        nodes_expanded++;
+        int row = curr_index / width;
+        int col = curr_index % width;
+
+        for (Side side : SIDES) {
+            if (!maze.is_passage_open(row, col, side)) {
+                continue;
+            }
+            size_t neighbor_index = curr_index + maze.get_index_offset(side);
+            if (other.is_visited(neighbor_index)) {
+                meet_self = curr_index;
+                meet_other = neighbor_index;
+                return true;
+            }
+            if (self.is_visited(neighbor_index)) {
+                continue;
+            }
+            self.mark_visited(neighbor_index);
+            self.set_parent(neighbor_index, static_cast<uint8_t>(Maze::get_opposite_side(side)));
+            queue.push_back(neighbor_index);
+        }
+        MAZE_TRACK_FRONTIER(queue.size() - head);
+    }
+    return false;
+}
+
+Path BidirectionalBFSSolver::solve(const Maze& maze, pair<int,int> start, pair<int,int> end) {
+    MAZE_PHASE(Phase::SOLVE);
+    nodes_expanded = 0;
+    forward.reset(maze.get_height(), maze.get_width());
+    backward.reset(maze.get_height(), maze.get_width());
+
+    size_t start_index = get_index(maze, start);
+    size_t end_index = get_index(maze, end);
+
+    if (start_index == end_index) {
+        nodes_expanded = 1;
+        return Path(start);
+    }
+
+    forward.mark_visited(start_index);
+    forward.stack.push_back(start_index);
+    backward.mark_visited(end_index);
+    backward.stack.push_back(end_index);
+
+    size_t forward_head = 0;
+    size_t backward_head = 0;
+    size_t meet_forward = 0;
+    size_t meet_backward = 0;
+    bool met = false;
+
+    while (!met && forward_head < forward.stack.size() && backward_head < backward.stack.size()) {
+        size_t forward_frontier = forward.stack.size() - forward_head;
+        size_t backward_frontier = backward.stack.size() - backward_head;
+
+        if (forward_frontier <= backward_frontier) {
+            met = expand_level(maze, forward, backward, forward_head, nodes_expanded, meet_forward, meet_backward);
+        } else {
+            met = expand_level(maze, backward, forward, backward_head, nodes_expanded, meet_backward, meet_forward);
+        }
+    }
+
+    if (!met) {
+        return Path();
+    }
+
+    Path path;
+    append_parent_chain(maze, forward, meet_forward, start_index, path);
+    path.reverse();
+    append_parent_chain(maze, backward, meet_backward, end_index, path);
+    return path;
+}
+
+string AStarSolver::get_name() const {
+    return "astar";
+}
+
+Path AStarSolver::solve(const Maze& maze, pair<int,int> start, pair<int,int> end) {
+    MAZE_PHASE(Phase::SOLVE);
+    nodes_expanded = 0;
+    workspace.reset(maze.get_height(), maze.get_width());
+    for (auto& bucket : buckets) {
+        bucket.clear();
+    }
+
+    size_t start_index = get_index(maze, start);
+    size_t end_index = get_index(maze, end);
+
+    auto heuristic = [&](pair<int,int> cell) {
+        return static_cast<uint32_t>(abs(cell.first - end.first) + abs(cell.second - end.second));
+    };
+
+    uint32_t priority = heuristic(start);
+    size_t queued = 1;
+    buckets[priority % 3].push_back({start_index, 0, 0});
+
+    while (queued > 0) {
+        vector<Entry>& bucket = buckets[priority % 3];
+        if (bucket.empty()) {
+            priority++;
+            continue;
+        }
+
+        // LIFO within a bucket prefers the most recently pushed, i.e. deepest, cells
+        Entry entry = bucket.back();
+        bucket.pop_back();
+        queued--;
+
+        if (workspace.is_visited(entry.index)) {
+            continue;
+        }
+        workspace.mark_visited(entry.index);
+        // parents are set on pop, a cell can be queued from several cells before it is expanded
+        workspace.set_parent(entry.index, entry.parent);
+        nodes_expanded++;
+
+        if (entry.index == end_index) {
+            break;
+        }
+
+        pair<int,int> curr_cell = get_cell(maze, entry.index);
+
+        for (Side side : SIDES) {
+            if (!maze.is_passage_open(curr_cell.first, curr_cell.second, side)) {
+                continue;
+            }
+            size_t neighbor_index = entry.index + maze.get_index_offset(side);
+            if (workspace.is_visited(neighbor_index)) {
+                continue;
+            }
+            uint32_t distance = entry.distance + 1;
+            uint32_t neighbor_priority = distance + heuristic(get_cell(maze, neighbor_index));
+            buckets[neighbor_priority % 3].push_back(
+                {neighbor_index, distance, static_cast<uint8_t>(Maze::get_opposite_side(side))});
+            queued++;
+        }
+        MAZE_TRACK_FRONTIER(queued);
+    }
+
+    if (!workspace.is_visited(end_index)) {
+        return Path();
+    }
+
+    Path path;
+    append_parent_chain(maze, workspace, end_index, start_index, path);
+    path.reverse();
+    return path;
+}
+
+string SpanningTreeSolver::get_name() const {
+    return "tree";
+}
+
+Path SpanningTreeSolver::solve(const Maze& maze, pair<int,int> start, pair<int,int> end) {
+    if (!maze.has_spanning_tree()) {
+        Path path = fallback.solve(maze, start, end);
+        nodes_expanded = fallback.get_nodes_expanded();
+        return path;
+    }
+    MAZE_PHASE(Phase::SOLVE);
+    Path to_start = maze.get_tree_path(start);
+    Path to_end = maze.get_tree_path(end);
+    nodes_expanded = to_start.size() + to_end.size();
+
+    // both paths leave the root together up to the last cell they share, where they part
+    size_t shared_steps = 0;
+    size_t max_shared_steps = min(to_start.size(), to_end.size()) - 1;
+    while (shared_steps < max_shared_steps && to_start.get_step(shared_steps) == to_end.get_step(shared_steps)) {
+        shared_steps++;
+    }
+
+    // back from start to where they part, then on to end
+    Path path(start);
+    for (size_t i = to_start.size() - 1; i > shared_steps; --i) {
+        path.add_step(Path::Step(Maze::get_opposite_side(Side(to_start.get_step(i - 1)))));
+    }
+    for (size_t i = shared_steps; i + 1 < to_end.size(); ++i) {
+        path.add_step(to_end.get_step(i));
+    }
+    return path;
+}
+
+vector<string> get_solver_names() {
+    return {"dfs", "bfs", "bibfs", "astar", "wavefront", "pbfs", "lpastar", "tree"};
+}
+
+unique_ptr<Solver> make_solver(const string& name) {
+    if (name == "dfs") {
+        return make_unique<DFSSolver>();
+    } else if (name == "bfs") {
+        return make_unique<BFSSolver>();
+    } else if (name == "bibfs") {
+        return make_unique<BidirectionalBFSSolver>();
+    } else if (name == "astar") {
+        return make_unique<AStarSolver>();
+    } else if (name == "wavefront") {
+        return make_unique<WavefrontSolver>();
+    } else if (name == "pbfs") {
+        return make_unique<ParallelBFSSolver>();
+    } else if (name == "lpastar") {
+        return make_unique<LPAStarSolver>();
+    } else if (name == "tree") {
+        return make_unique<SpanningTreeSolver>();
+    }
+    return nullptr;
+}
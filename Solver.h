@@ -0,0 +1,117 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "Maze.h"
+#include "Path.h"
+#include "SolverWorkspace.h"
+
+/*
+* Algorithm that finds a Path between two cells of a Maze.
+*
+* Solvers keep their workspace between calls, so solving many same-sized mazes with one
+* solver object does not reallocate. A solver is not safe to use from several threads at once.
+*/
+class Solver {
+protected:
+    size_t nodes_expanded = 0;
+
+    // returns flat index (row * width + col) of a cell
+    static size_t get_index(const Maze& maze, std::pair<int,int> cell);
+
+    // returns (row, col) of a flat index
+    static std::pair<int,int> get_cell(const Maze& maze, size_t index);
+
+public:
+    virtual ~Solver() = default;
+
+    // name used to select the solver, e.g. on the command line
+    virtual std::string get_name() const = 0;
+
+    /*
+    * Finds a path from start to end.
+    * @return path starting at start and ending at end, or an empty path if end can't be reached.
+    */
+    virtual Path solve(const Maze& maze, std::pair<int,int> start, std::pair<int,int> end) = 0;
+
+    // returns number of cells expanded by the last solve
+    size_t get_nodes_expanded() const;
+};
+
+// Depth first search, same algorithm as Maze::solveMazeDFS.
+class DFSSolver : public Solver {
+    SolverWorkspace workspace;
+
+public:
+    std::string get_name() const override;
+    Path solve(const Maze& maze, std::pair<int,int> start, std::pair<int,int> end) override;
+
+    // solves with a workspace owned by the caller
+    Path solve(const Maze& maze, std::pair<int,int> start, std::pair<int,int> end, SolverWorkspace& workspace);
+};
+
+// Breadth first search, finds a shortest path.
+class BFSSolver : public Solver {
+    SolverWorkspace workspace;
+
+public:
+    std::string get_name() const override;
+    Path solve(const Maze& maze, std::pair<int,int> start, std::pair<int,int> end) override;
+};
+
+/*
+* Breadth first search from both ends at once, always growing the smaller frontier by one level.
+* Finds a shortest path and usually expands far fewer cells than BFS on open mazes.
+*/
+class BidirectionalBFSSolver : public Solver {
+    SolverWorkspace forward;
+    SolverWorkspace backward;
+
+public:
+    std::string get_name() const override;
+    Path solve(const Maze& maze, std::pair<int,int> start, std::pair<int,int> end) override;
+};
+
+/*
+* A* search with the Manhattan distance heuristic.
+* All moves cost 1, so the open set is a bucket queue: a popped cell with priority f can only
+* push priorities f (towards the end) or f + 2 (away from it), three rotating buckets are enough.
+*/
+class AStarSolver : public Solver {
+    struct Entry {
+        size_t index;
+        uint32_t distance;
+        uint8_t parent;
+    };
+
+    SolverWorkspace workspace;
+    std::vector<Entry> buckets[3];
+
+public:
+    std::string get_name() const override;
+    Path solve(const Maze& maze, std::pair<int,int> start, std::pair<int,int> end) override;
+};
+
+/*
+* Reads the path off the spanning tree a maze recorded while it was generated (see
+* Maze::has_spanning_tree), without searching: both cells walk up to (0,0) and the walks are
+* joined where they meet. Falls back to depth first search on mazes without a tree, e.g. loaded
+* or edited ones.
+*/
+class SpanningTreeSolver : public Solver {
+    DFSSolver fallback;
+
+public:
+    std::string get_name() const override;
+    Path solve(const Maze& maze, std::pair<int,int> start, std::pair<int,int> end) override;
+};
+
+// returns names accepted by make_solver
+std::vector<std::string> get_solver_names();
+
+/*
+* Creates a solver by name.
+* @return the solver, or nullptr if there is no solver with that name.
+*/
+std::unique_ptr<Solver> make_solver(const std::string& name);
@@ -0,0 +1,59 @@
+#include "SolverWorkspace.h"
+#include "Instrument.h"
+#include "VisitQueue.h"
+#include <algorithm>
+#include <assert.h>
+
+using namespace std;
+
+SolverWorkspace::SolverWorkspace() : height(0), width(0), epoch(0) {}
+
+void SolverWorkspace::reset(int h, int w) {
+    size_t cell_count = static_cast<size_t>(h) * w;
+    if (h != height || w != width) {
+        height = h;
+        width = w;
+        visited.assign(cell_count, 0);
+        parent.assign(cell_count, 0);
+        epoch = 0;
+        MAZE_COUNT_ALLOCATION(cell_count * (sizeof(uint32_t) + sizeof(uint8_t)));
+    }
+
+    epoch++;
+    if (epoch == 0) {
+        // stamps wrapped around, old marks could look current again
+        fill(visited.begin(), visited.end(), 0);
+        epoch = 1;
+    }
+    stack.clear();
+}
+
+int SolverWorkspace::get_height() const {
+    return height;
+}
+
+int SolverWorkspace::get_width() const {
+    return width;
+}
+
+bool SolverWorkspace::is_visited(size_t index) const {
+    assert(index < visited.size());
+    return visited[index] == epoch;
+}
+
+void SolverWorkspace::mark_visited(size_t index) {
+    assert(index < visited.size());
+    visited[index] = epoch;
+    MAZE_COUNT_VISIT(index);
+    publish_visit(index);
+}
+
+uint8_t SolverWorkspace::get_parent(size_t index) const {
+    assert(index < parent.size());
+    return parent[index];
+}
+
+void SolverWorkspace::set_parent(size_t index, uint8_t direction) {
+    assert(index < parent.size());
+    parent[index] = direction;
+}
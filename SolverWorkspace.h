@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+* Scratch memory for maze solvers, addressed by flat cell index (row * width + col).
+*
+* Holds the visited marks, the direction back to the parent of every cell and a stack of
+* cell indices. Reusing one workspace across solves of same-sized mazes allocates nothing:
+* visited marks are epoch stamps, so reset() only bumps a counter instead of clearing memory.
+*/
+class SolverWorkspace {
+    int height;
+    int width;
+    uint32_t epoch;
+    std::vector<uint32_t> visited;
+    std::vector<uint8_t> parent;
+
+public:
+    // flat cell indices waiting to be expanded, cleared by reset()
+    std::vector<size_t> stack;
+
+    /*
+    * Initializes an empty workspace, memory is allocated by the first reset.
+    */
+    SolverWorkspace();
+
+    /*
+    * Prepares the workspace for a solve on a maze of the given size. Memory is only
+    * reallocated if the size differs from the previous solve.
+    * @param height number of cell rows
+    * @param width number of cell cols
+    */
+    void reset(int height, int width);
+
+    int get_height() const;
+    int get_width() const;
+
+    bool is_visited(size_t index) const;
+    void mark_visited(size_t index);
+
+    /*
+    * Direction from the cell to its parent, the meaning of the value is up to the solver.
+    */
+    uint8_t get_parent(size_t index) const;
+    void set_parent(size_t index, uint8_t direction);
+};
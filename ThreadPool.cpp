@@ -0,0 +1,109 @@
+#include "ThreadPool.h"
+
+using namespace std;
+
+ThreadPool::ThreadPool(int thread_count) : queued(0), pending(0), next_queue(0), stopping(false) {
+    if (thread_count <= 0) {
+        thread_count = max(1u, thread::hardware_concurrency());
+    }
+    for (int i = 0; i < thread_count; ++i) {
+        queues.push_back(make_unique<WorkerQueue>());
+    }
+    for (int i = 0; i < thread_count; ++i) {
+        threads.emplace_back(&ThreadPool::run_worker, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    wait();
+    {
+        lock_guard<mutex> lock(state_mutex);
+        stopping = true;
+    }
+    work_available.notify_all();
+    for (auto& worker : threads) {
+        worker.join();
+    }
+}
+
+int ThreadPool::get_thread_count() const {
+    return threads.size();
+}
+
+void ThreadPool::submit(function<void(int)> task) {
+    {
+        // the counters are raised before any worker can finish the task
+        lock_guard<mutex> lock(state_mutex);
+        WorkerQueue& queue = *queues[next_queue];
+        next_queue = (next_queue + 1) % queues.size();
+        {
+            lock_guard<mutex> queue_lock(queue.mutex);
+            queue.tasks.push_back(move(task));
+        }
+        queued++;
+        pending++;
+    }
+    work_available.notify_one();
+}
+
+void ThreadPool::wait() {
+    unique_lock<mutex> lock(state_mutex);
+    all_done.wait(lock, [this] { return pending == 0; });
+}
+
+bool ThreadPool::take_task(int worker, function<void(int)>& task) {
+    {
+        WorkerQueue& own = *queues[worker];
+        lock_guard<mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    for (size_t i = 1; i < queues.size(); ++i) {
+        WorkerQueue& victim = *queues[(worker + i) % queues.size()];
+        lock_guard<mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::run_worker(int worker) {
+    function<void(int)> task;
+
+    while (true) {
+        {
+            unique_lock<mutex> lock(state_mutex);
+            work_available.wait(lock, [this] { return stopping || queued > 0; });
+            if (queued == 0) {
+                return;
+            }
+        }
+
+        if (!take_task(worker, task)) {
+            // another worker got it first
+            continue;
+        }
+        {
+            lock_guard<mutex> lock(state_mutex);
+            queued--;
+        }
+
+        task(worker);
+        task = nullptr;
+
+        {
+            lock_guard<mutex> lock(state_mutex);
+            pending--;
+            if (pending == 0) {
+                all_done.notify_all();
+            }
+        }
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+* Fixed-size thread pool with work stealing.
+*
+* Every worker has its own task deque. Submitted tasks are spread round-robin over the deques,
+* a worker takes tasks from the back of its own deque and, once that is empty, steals from the
+* front of the others, so uneven task sizes still keep every core busy.
+*
+* Tasks get the index of the worker running them, which lets callers keep per-worker state
+* (e.g. solver workspaces) without locks.
+*/
+class ThreadPool {
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<std::function<void(int)>> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> threads;
+    std::mutex state_mutex;
+    std::condition_variable work_available;
+    std::condition_variable all_done;
+    int64_t queued;
+    int64_t pending;
+    size_t next_queue;
+    bool stopping;
+
+    void run_worker(int worker);
+
+    // pops from the worker's own deque, or steals from another one
+    bool take_task(int worker, std::function<void(int)>& task);
+
+public:
+    /*
+    * Starts the workers.
+    * @param thread_count number of workers, 0 uses one per hardware thread
+    */
+    explicit ThreadPool(int thread_count = 0);
+
+    // waits for queued tasks to finish and stops the workers
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int get_thread_count() const;
+
+    /*
+    * Queues a task.
+    * @param task called with the index of the worker that runs it, in [0, get_thread_count()).
+    * Must not throw.
+    */
+    void submit(std::function<void(int)> task);
+
+    // blocks until every submitted task has finished
+    void wait();
+};
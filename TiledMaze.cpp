@@ -0,0 +1,192 @@
+#include "TiledMaze.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+const char TILED_MAZE_FILE_MAGIC[8] = {'M', 'A', 'Z', 'E', 'T', 'I', 'L', 'E'};
+const uint32_t TILED_MAZE_FILE_VERSION = 1;
+
+// number of tiles needed to cover that many cells
+static uint64_t get_tiles_along(int cells, uint32_t tile_size) {
+    return (static_cast<uint64_t>(cells) + tile_size - 1) / tile_size;
+}
+
+// words of one tile of wall bits, 32 cells per word
+static size_t get_tile_words(uint32_t tile_size) {
+    return static_cast<size_t>(tile_size) * tile_size / 32;
+}
+
+TiledMazeHeader make_tiled_maze_header(int width, int height, uint32_t tile_size) {
+    TiledMazeHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TILED_MAZE_FILE_MAGIC, sizeof(header.magic));
+    header.version = TILED_MAZE_FILE_VERSION;
+    header.header_size = sizeof(TiledMazeHeader);
+    header.width = width;
+    header.height = height;
+    header.end_row = height - 1;
+    header.end_col = width - 1;
+    header.tile_size = tile_size;
+    header.tile_count = get_tiles_along(width, tile_size) * get_tiles_along(height, tile_size);
+    return header;
+}
+
+TiledMazeWriter::TiledMazeWriter(const string& filename, const TiledMazeHeader& h)
+    : out(filename, ios::binary), header(h), tiles_across(get_tiles_along(h.width, h.tile_size)),
+      tile_words(get_tile_words(h.tile_size)), rows_written(0) {
+    if (!out) {
+        throw runtime_error("Could not create " + filename);
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    band.assign(tiles_across * tile_words, ~uint64_t(0));
+}
+
+void TiledMazeWriter::write_row(const vector<uint8_t>& walls) {
+    uint32_t tile_size = header.tile_size;
+    size_t local_row = rows_written % tile_size;
+    for (size_t col = 0; col < walls.size(); ++col) {
+        size_t local = local_row * tile_size + col % tile_size;
+        uint64_t& word = band[(col / tile_size) * tile_words + local / 32];
+        int shift = 2 * (local % 32);
+        word = (word & ~(uint64_t(3) << shift)) | (static_cast<uint64_t>(walls[col] & 3) << shift);
+    }
+    rows_written++;
+    if (rows_written % tile_size == 0) {
+        write_band();
+    }
+}
+
+void TiledMazeWriter::write_band() {
+    out.write(reinterpret_cast<const char*>(band.data()), band.size() * sizeof(uint64_t));
+    fill(band.begin(), band.end(), ~uint64_t(0));
+}
+
+void TiledMazeWriter::close() {
+    if (rows_written != static_cast<uint64_t>(header.height)) {
+        throw runtime_error("Tiled maze file closed after " + to_string(rows_written) + " of "
+            + to_string(header.height) + " rows");
+    }
+    if (rows_written % header.tile_size != 0) {
+        // the rows past the height stay walled, like the padding of a freshly built WallGrid
+        write_band();
+    }
+    out.close();
+    if (!out) {
+        throw runtime_error("Could not write tiled maze file");
+    }
+}
+
+TiledMaze::TiledMaze(const string& filename, size_t cache_bytes) : fd(-1) {
+    fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw runtime_error("Could not open " + filename);
+    }
+
+    try {
+        if (pread(fd, &header, sizeof(header), 0) != sizeof(header)) {
+            throw runtime_error("Tiled maze file is too small for a header");
+        }
+        if (memcmp(header.magic, TILED_MAZE_FILE_MAGIC, sizeof(header.magic)) != 0) {
+            throw runtime_error("Not a tiled maze file");
+        }
+        if (header.version != TILED_MAZE_FILE_VERSION || header.header_size != sizeof(TiledMazeHeader)) {
+            throw runtime_error("Unsupported tiled maze file version " + to_string(header.version));
+        }
+        uint32_t tile_size = header.tile_size;
+        if (header.width <= 0 || header.height <= 0 || tile_size < 8 || (tile_size & (tile_size - 1)) != 0
+            || header.tile_count != get_tiles_along(header.width, tile_size) * get_tiles_along(header.height, tile_size)) {
+            throw runtime_error("Tiled maze file has an invalid size");
+        }
+        if (header.start_row < 0 || header.start_row >= header.height || header.start_col < 0 || header.start_col >= header.width
+            || header.end_row < 0 || header.end_row >= header.height || header.end_col < 0 || header.end_col >= header.width) {
+            throw runtime_error("Tiled maze file has start or end outside of the maze");
+        }
+        if (header.generator >= get_generator_names().size()) {
+            throw runtime_error("Tiled maze file has unknown generator " + to_string(header.generator));
+        }
+        struct stat file_stat;
+        if (fstat(fd, &file_stat) != 0
+            || static_cast<uint64_t>(file_stat.st_size) < sizeof(header) + header.tile_count * get_tile_bytes()) {
+            throw runtime_error("Tiled maze file is truncated");
+        }
+        if (cache_bytes < get_tile_bytes()) {
+            throw runtime_error("Tile cache must hold at least one tile of " + to_string(get_tile_bytes()) + " bytes");
+        }
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+
+    tile_shift = __builtin_ctz(header.tile_size);
+    tile_mask = header.tile_size - 1;
+    tiles_across = get_tiles_along(header.width, header.tile_size);
+    cache = make_unique<BlockCache>(fd, sizeof(header), get_tile_bytes(), header.tile_count,
+        cache_bytes / get_tile_bytes(), false);
+}
+
+TiledMaze::~TiledMaze() {
+    cache.reset();
+    ::close(fd);
+}
+
+const TiledMazeHeader& TiledMaze::get_header() const {
+    return header;
+}
+
+int TiledMaze::get_height() const {
+    return header.height;
+}
+
+int TiledMaze::get_width() const {
+    return header.width;
+}
+
+pair<int,int> TiledMaze::get_start_location() const {
+    return make_pair(header.start_row, header.start_col);
+}
+
+pair<int,int> TiledMaze::get_end_location() const {
+    return make_pair(header.end_row, header.end_col);
+}
+
+uint32_t TiledMaze::get_tile_size() const {
+    return header.tile_size;
+}
+
+size_t TiledMaze::get_tile_bytes() const {
+    return get_tile_words(header.tile_size) * sizeof(uint64_t);
+}
+
+bool TiledMaze::get_wall_bit(int row, int col, int bit) {
+    uint64_t tile = (static_cast<uint64_t>(row) >> tile_shift) * tiles_across + (col >> tile_shift);
+    size_t local = (static_cast<size_t>(row & tile_mask) << tile_shift) | (col & tile_mask);
+    const uint64_t* words = cache->get(tile);
+    return (words[local >> 5] >> (((local & 31) << 1) + bit)) & 1;
+}
+
+bool TiledMaze::is_passage_open(int row, int col, Side side) {
+    switch (side) {
+        case Side::TOP:
+            return row > 0 && !get_wall_bit(row - 1, col, 1);
+        case Side::BOTTOM:
+            return row < header.height - 1 && !get_wall_bit(row, col, 1);
+        case Side::LEFT:
+            return col > 0 && !get_wall_bit(row, col - 1, 0);
+        case Side::RIGHT:
+            return col < header.width - 1 && !get_wall_bit(row, col, 0);
+    }
+    return false;
+}
+
+const BlockCache::Stats& TiledMaze::get_cache_stats() const {
+    return cache->get_stats();
+}
+
+size_t TiledMaze::get_cache_capacity() const {
+    return cache->get_capacity();
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "BlockCache.h"
+#include "Maze.h"
+
+/*
+* Tiled binary maze file, version 1, for mazes larger than memory.
+*
+* A 64 byte TiledMazeHeader followed by the tiles in row-major tile order. A tile holds the walls
+* of tile_size x tile_size cells in the WallGrid layout (east and south wall bits of the cells,
+* row-major inside the tile, 32 cells per little-endian 64 bit word), so the cells next to a
+* cell are almost always in the same tile. Tiles on the right and bottom edge are padded with
+* walled cells.
+*/
+struct TiledMazeHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    int32_t width;
+    int32_t height;
+    int32_t start_row;
+    int32_t start_col;
+    int32_t end_row;
+    int32_t end_col;
+    uint64_t seed;
+    uint32_t generator;
+    uint32_t tile_size;
+    uint64_t tile_count;
+};
+
+static_assert(sizeof(TiledMazeHeader) == 64, "tiled maze file header must stay 64 bytes");
+
+extern const char TILED_MAZE_FILE_MAGIC[8];
+extern const uint32_t TILED_MAZE_FILE_VERSION;
+
+// cells per tile side used unless asked otherwise, a tile of walls is then 16 KB
+static const uint32_t DEFAULT_TILE_SIZE = 256;
+
+/*
+* Returns a header with magic, version, sizes and tile count filled in for a maze of that size.
+* @param tile_size cells per tile side, a power of two of at least 8
+*/
+TiledMazeHeader make_tiled_maze_header(int width, int height, uint32_t tile_size = DEFAULT_TILE_SIZE);
+
+/*
+* Writes a tiled maze file one row of cells at a time, e.g. from an EllerGenerator. One band of
+* tile_size rows is buffered, a quarter byte per cell of the width.
+*/
+class TiledMazeWriter {
+    std::ofstream out;
+    TiledMazeHeader header;
+    uint64_t tiles_across;
+    size_t tile_words;
+    std::vector<uint64_t> band;
+    uint64_t rows_written;
+
+    // writes the buffered band of tiles and starts a new one with every wall built
+    void write_band();
+
+public:
+    /*
+    * Creates the file and writes the header.
+    * Throws std::runtime_error if the file can't be created.
+    */
+    TiledMazeWriter(const std::string& filename, const TiledMazeHeader& header);
+
+    /*
+    * Appends a row of cells, each a combination of EllerGenerator::EAST_WALL and SOUTH_WALL.
+    */
+    void write_row(const std::vector<uint8_t>& walls);
+
+    /*
+    * Writes the last band and closes the file.
+    * Throws std::runtime_error if not every row was written or the write failed.
+    */
+    void close();
+};
+
+/*
+* Read-only maze in a tiled maze file, paged in tile by tile through a BlockCache so only a
+* bounded number of tiles is in memory at once.
+*/
+class TiledMaze {
+    using Side = Maze::Side;
+
+    int fd;
+    TiledMazeHeader header;
+    int tile_shift;
+    int tile_mask;
+    uint64_t tiles_across;
+    std::unique_ptr<BlockCache> cache;
+
+    // returns the wall bit of a cell, bit 0 is east and bit 1 is south
+    bool get_wall_bit(int row, int col, int bit);
+
+public:
+    /*
+    * Opens the file and checks its header.
+    * Throws std::runtime_error if the file can't be read or isn't a valid tiled maze.
+    * @param cache_bytes memory for cached tiles, at least one tile
+    */
+    TiledMaze(const std::string& filename, size_t cache_bytes);
+    ~TiledMaze();
+
+    TiledMaze(const TiledMaze&) = delete;
+    TiledMaze& operator=(const TiledMaze&) = delete;
+
+    const TiledMazeHeader& get_header() const;
+    int get_height() const;
+    int get_width() const;
+    std::pair<int,int> get_start_location() const;
+    std::pair<int,int> get_end_location() const;
+
+    // cells per tile side and bytes of one tile of walls
+    uint32_t get_tile_size() const;
+    size_t get_tile_bytes() const;
+
+    // returns true if the cell has a neighbor on that side and no wall in between
+    bool is_passage_open(int row, int col, Side side);
+
+    // I/O counts of the tile cache
+    const BlockCache::Stats& get_cache_stats() const;
+    size_t get_cache_capacity() const;
+};
@@ -0,0 +1,114 @@
+#include "TiledSolver.h"
+#include <stdexcept>
+#include <vector>
+#include <stdlib.h>
+#include <unistd.h>
+#include "Instrument.h"
+
+using namespace std;
+
+using Side = Maze::Side;
+
+// order in which sides are tried, and the position of every Side in it
+static const Side SIDES[] = {Side::TOP, Side::RIGHT, Side::BOTTOM, Side::LEFT};
+static const int SIDE_POSITION[] = {0, 3, 2, 1};
+
+TiledSolver::TiledSolver(const string& directory, size_t bytes)
+    : scratch_directory(directory), cache_bytes(bytes), nodes_expanded(0) {}
+
+Path TiledSolver::solve(TiledMaze& maze, pair<int,int> start, pair<int,int> end) {
+    MAZE_PHASE(Phase::SOLVE);
+    nodes_expanded = 0;
+    visited_stats = BlockCache::Stats();
+
+    uint32_t tile_size = maze.get_tile_size();
+    int tile_shift = __builtin_ctz(tile_size);
+    int tile_mask = tile_size - 1;
+    uint64_t tiles_across = (static_cast<uint64_t>(maze.get_width()) + tile_size - 1) / tile_size;
+    size_t block_bytes = static_cast<size_t>(tile_size) * tile_size / 8;
+    if (cache_bytes < block_bytes) {
+        throw runtime_error("Visited cache must hold at least one block of " + to_string(block_bytes) + " bytes");
+    }
+
+    // the scratch file is unlinked right away, so it goes away with the descriptor
+    string scratch_name = scratch_directory + "/maze-visited-XXXXXX";
+    vector<char> name_buffer(scratch_name.begin(), scratch_name.end());
+    name_buffer.push_back('\0');
+    int fd = mkstemp(name_buffer.data());
+    if (fd < 0) {
+        throw runtime_error("Could not create a scratch file in " + scratch_directory);
+    }
+    unlink(name_buffer.data());
+
+    Path path(start);
+    try {
+        BlockCache visited(fd, 0, block_bytes, maze.get_header().tile_count, cache_bytes / block_bytes, true);
+
+        // returns the visited bit of a cell and sets it
+        auto visit = [&](pair<int,int> cell) {
+            uint64_t tile = (static_cast<uint64_t>(cell.first) >> tile_shift) * tiles_across + (cell.second >> tile_shift);
+            size_t local = (static_cast<size_t>(cell.first & tile_mask) << tile_shift) | (cell.second & tile_mask);
+            uint64_t* words = visited.get(tile, true);
+            uint64_t bit = uint64_t(1) << (local & 63);
+            bool was_visited = words[local >> 6] & bit;
+            words[local >> 6] |= bit;
+            return was_visited;
+        };
+
+        visit(start);
+        nodes_expanded++;
+        MAZE_COUNT_VISIT(static_cast<uint64_t>(start.first) * maze.get_width() + start.second);
+        pair<int,int> current = start;
+        // position in SIDES of the next side to try from the current cell
+        int next = 0;
+
+        while (current != end) {
+            bool moved = false;
+            for (; next < 4; ++next) {
+                Side side = SIDES[next];
+                if (!maze.is_passage_open(current.first, current.second, side)) {
+                    continue;
+                }
+                pair<int,int> neighbor = Path::get_neighbor(current, Path::Step(side));
+                if (visit(neighbor)) {
+                    continue;
+                }
+                nodes_expanded++;
+                MAZE_COUNT_VISIT(static_cast<uint64_t>(neighbor.first) * maze.get_width() + neighbor.second);
+                path.add_step(Path::Step(side));
+                current = neighbor;
+                next = 0;
+                moved = true;
+                break;
+            }
+
+            if (!moved) {
+                if (path.size() == 1) {
+                    // every cell reachable from start was visited
+                    path = Path();
+                    break;
+                }
+                // back to the previous cell, continue after the side that led here
+                Path::Step back = path.pop_step();
+                current = path.get_end();
+                next = SIDE_POSITION[static_cast<int>(back)] + 1;
+            }
+            MAZE_TRACK_FRONTIER(path.size());
+        }
+
+        visited_stats = visited.get_stats();
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    ::close(fd);
+    return path;
+}
+
+uint64_t TiledSolver::get_nodes_expanded() const {
+    return nodes_expanded;
+}
+
+const BlockCache::Stats& TiledSolver::get_visited_stats() const {
+    return visited_stats;
+}
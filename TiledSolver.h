@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "BlockCache.h"
+#include "Path.h"
+#include "TiledMaze.h"
+
+/*
+* Depth first search over a TiledMaze with bounded memory, for mazes larger than RAM.
+*
+* Visited bits live in an unlinked scratch file with one block per tile (a bit per cell) and are
+* paged through their own BlockCache, next to the wall tiles of the maze. The search stack is
+* the path being built: backtracking pops the last 2 bit step and tries the sides after the one
+* it came back through, so the stack costs a quarter byte per cell of the current branch.
+* The stack is not paged and is not part of cache_bytes: a branch through billions of cells
+* takes gigabytes of memory on top of the caches.
+*/
+class TiledSolver {
+    std::string scratch_directory;
+    size_t cache_bytes;
+    uint64_t nodes_expanded;
+    BlockCache::Stats visited_stats;
+
+public:
+    /*
+    * @param scratch_directory where the visited bits are paged out to
+    * @param cache_bytes memory for cached blocks of visited bits, at least one block
+    */
+    TiledSolver(const std::string& scratch_directory, size_t cache_bytes);
+
+    /*
+    * Finds a path from start to end.
+    * Throws std::runtime_error if the scratch file can't be created, read or written.
+    * @return path starting at start and ending at end, or an empty path if end can't be reached.
+    */
+    Path solve(TiledMaze& maze, std::pair<int,int> start, std::pair<int,int> end);
+
+    // returns number of cells expanded by the last solve
+    uint64_t get_nodes_expanded() const;
+
+    // I/O counts of the visited bits of the last solve
+    const BlockCache::Stats& get_visited_stats() const;
+};
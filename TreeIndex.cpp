@@ -0,0 +1,160 @@
+#include "TreeIndex.h"
+#include "Instrument.h"
+#include <algorithm>
+#include <assert.h>
+#include <stdexcept>
+
+using namespace std;
+
+using Side = Maze::Side;
+
+static const uint32_t UNVISITED = UINT32_MAX;
+
+TreeIndex::TreeIndex(const Maze& maze) : height(maze.get_height()), width(maze.get_width()) {
+    MAZE_PHASE(Phase::INDEX);
+    const Side sides[] = {Side::TOP, Side::RIGHT, Side::BOTTOM, Side::LEFT};
+    size_t cell_count = static_cast<size_t>(height) * width;
+    if (cell_count >= UNVISITED) {
+        throw invalid_argument("Maze is too large for a tree index");
+    }
+
+    parent.assign(cell_count, 0);
+    jump.assign(cell_count, 0);
+    depth.assign(cell_count, UNVISITED);
+
+    // bfs from the root, a parent is always finished before its children
+    vector<uint32_t> queue;
+    queue.reserve(cell_count);
+    MAZE_COUNT_ALLOCATION(cell_count * (sizeof(parent[0]) + sizeof(jump[0]) + sizeof(depth[0]) + sizeof(queue[0])));
+    queue.push_back(0);
+    depth[0] = 0;
+    jump[0] = 0;
+
+    for (size_t head = 0; head < queue.size(); ++head) {
+        uint32_t index = queue[head];
+        int row = index / width;
+        int col = index % width;
+
+        for (Side side : sides) {
+            if (!maze.is_passage_open(row, col, side)) {
+                continue;
+            }
+            uint32_t child = index + maze.get_index_offset(side);
+            if (index != 0 && child == get_parent_index(index)) {
+                continue;
+            }
+            if (depth[child] != UNVISITED) {
+                throw invalid_argument("Maze has a loop, it is not a spanning tree");
+            }
+
+            parent[child] = static_cast<uint8_t>(Maze::get_opposite_side(side));
+            depth[child] = depth[index] + 1;
+
+            // jump two levels further than the parent's jump when the parent's jump and
+            // its jump's jump cover the same distance, otherwise jump to the parent
+            uint32_t parent_jump = jump[index];
+            if (depth[index] - depth[parent_jump] == depth[parent_jump] - depth[jump[parent_jump]]) {
+                jump[child] = jump[parent_jump];
+            } else {
+                jump[child] = index;
+            }
+            queue.push_back(child);
+        }
+    }
+
+    if (queue.size() != cell_count) {
+        throw invalid_argument("Maze has cells that can't be reached, it is not a spanning tree");
+    }
+}
+
+size_t TreeIndex::get_index(pair<int,int> cell) const {
+    assert(cell.first >= 0 && cell.first < height);
+    assert(cell.second >= 0 && cell.second < width);
+    return static_cast<size_t>(cell.first) * width + cell.second;
+}
+
+pair<int,int> TreeIndex::get_cell(size_t index) const {
+    return make_pair(index / width, index % width);
+}
+
+uint32_t TreeIndex::get_parent_index(uint32_t index) const {
+    switch (Side(parent[index])) {
+        case Side::TOP:
+            return index - width;
+        case Side::BOTTOM:
+            return index + width;
+        case Side::LEFT:
+            return index - 1;
+        case Side::RIGHT:
+            return index + 1;
+        default:
+            throw;
+    }
+}
+
+uint32_t TreeIndex::get_ancestor(uint32_t index, uint32_t target_depth) const {
+    assert(target_depth <= depth[index]);
+    while (depth[index] > target_depth) {
+        if (depth[jump[index]] >= target_depth) {
+            index = jump[index];
+        } else {
+            index = get_parent_index(index);
+        }
+    }
+    return index;
+}
+
+uint32_t TreeIndex::get_lowest_common_ancestor(uint32_t a, uint32_t b) const {
+    if (depth[a] > depth[b]) {
+        a = get_ancestor(a, depth[b]);
+    } else {
+        b = get_ancestor(b, depth[a]);
+    }
+
+    // jump pointers only depend on depth, so a and b jump in lockstep
+    while (a != b) {
+        if (jump[a] != jump[b]) {
+            a = jump[a];
+            b = jump[b];
+        } else {
+            a = get_parent_index(a);
+            b = get_parent_index(b);
+        }
+    }
+    return a;
+}
+
+size_t TreeIndex::get_distance(pair<int,int> from, pair<int,int> to) const {
+    uint32_t a = get_index(from);
+    uint32_t b = get_index(to);
+    uint32_t ancestor = get_lowest_common_ancestor(a, b);
+    return depth[a] + depth[b] - 2 * depth[ancestor];
+}
+
+pair<int,int> TreeIndex::get_lowest_common_ancestor(pair<int,int> a, pair<int,int> b) const {
+    return get_cell(get_lowest_common_ancestor(get_index(a), get_index(b)));
+}
+
+Path TreeIndex::get_path(pair<int,int> from, pair<int,int> to) const {
+    uint32_t a = get_index(from);
+    uint32_t b = get_index(to);
+    uint32_t ancestor = get_lowest_common_ancestor(a, b);
+
+    // up from `from` to the ancestor
+    Path path(from);
+    for (uint32_t index = a; index != ancestor; ) {
+        index = get_parent_index(index);
+        path.add(get_cell(index));
+    }
+
+    // up from `to` to the ancestor, appended in reverse
+    Path down(to);
+    for (uint32_t index = b; index != ancestor; ) {
+        index = get_parent_index(index);
+        down.add(get_cell(index));
+    }
+    down.reverse();
+    path.append(down);
+
+    return path;
+}
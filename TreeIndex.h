@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Maze.h"
+#include "Path.h"
+
+/*
+* Index for path queries between any two cells of a perfect maze (a spanning tree).
+*
+* Built once in O(cells) by rooting the tree at (0,0). Every cell stores its depth, the direction
+* to its parent and one jump pointer to an ancestor. Jump pointers follow the skew-binary scheme,
+* a compact form of binary lifting: ancestors and lowest common ancestors are found in O(log n)
+* while memory stays at 9 bytes per cell instead of 4 * log(n).
+*
+* The distance between two cells is then O(log n) and the full Path O(log n + path length).
+*/
+class TreeIndex {
+    int height;
+    int width;
+    std::vector<uint8_t> parent;
+    std::vector<uint32_t> jump;
+    std::vector<uint32_t> depth;
+
+    size_t get_index(std::pair<int,int> cell) const;
+    std::pair<int,int> get_cell(size_t index) const;
+    uint32_t get_parent_index(uint32_t index) const;
+
+    // returns the ancestor of index at the given depth, which must not be below index
+    uint32_t get_ancestor(uint32_t index, uint32_t target_depth) const;
+
+    uint32_t get_lowest_common_ancestor(uint32_t a, uint32_t b) const;
+
+public:
+    /*
+    * Builds the index.
+    * Throws std::invalid_argument if the maze is not a spanning tree, i.e. it has loops
+    * or cells that can't be reached from (0,0).
+    */
+    explicit TreeIndex(const Maze& maze);
+
+    // returns number of steps on the path between the two cells
+    size_t get_distance(std::pair<int,int> from, std::pair<int,int> to) const;
+
+    // returns the cell where the paths from the two cells to (0,0) meet
+    std::pair<int,int> get_lowest_common_ancestor(std::pair<int,int> a, std::pair<int,int> b) const;
+
+    // returns the path between the two cells, starting at from and ending at to
+    Path get_path(std::pair<int,int> from, std::pair<int,int> to) const;
+};
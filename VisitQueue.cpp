@@ -0,0 +1,46 @@
+#include "VisitQueue.h"
+#include <algorithm>
+
+using namespace std;
+
+VisitQueue::VisitQueue(size_t c) : head(0), tail(0), cached_head(0), dropped(0), closed(false), cancelled(false), capacity(1) {
+    while (capacity < c) {
+        capacity <<= 1;
+    }
+    cells.reset(new uint64_t[capacity]);
+}
+
+size_t VisitQueue::pop(uint64_t* out, size_t max_count) {
+    uint64_t position = head.load(memory_order_relaxed);
+    size_t count = min<uint64_t>(tail.load(memory_order_acquire) - position, max_count);
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = cells[(position + i) & (capacity - 1)];
+    }
+    head.store(position + count, memory_order_release);
+    return count;
+}
+
+void VisitQueue::close() {
+    closed.store(true, memory_order_release);
+}
+
+bool VisitQueue::is_closed() const {
+    return closed.load(memory_order_acquire);
+}
+
+void VisitQueue::cancel() {
+    cancelled.store(true, memory_order_relaxed);
+    close();
+}
+
+bool VisitQueue::is_cancelled() const {
+    return cancelled.load(memory_order_relaxed);
+}
+
+uint64_t VisitQueue::get_dropped() const {
+    return dropped.load(memory_order_relaxed);
+}
+
+void VisitQueue::set_current(VisitQueue* queue) {
+    current = queue;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/*
+* Lock-free single producer, single consumer ring of visited cells, which lets a solver run at
+* full speed while another thread (a MazeRenderer) watches it.
+*
+* The producer never waits: when the consumer falls behind and the ring is full, new visits are
+* dropped and counted. The consumer takes everything queued in one batch, so a slow consumer
+* coalesces many visits into one frame. Head and tail live on their own cache lines, and the
+* producer only rereads the head when the ring looks full, so the two threads rarely touch the
+* same line.
+*
+* Solvers publish to the queue of their thread, see set_current(). With no queue set, publishing
+* costs one thread-local load and a branch per visit.
+*/
+class VisitQueue {
+    // next index to pop, written by the consumer
+    alignas(64) std::atomic<uint64_t> head;
+
+    // next index to push, written by the producer
+    alignas(64) std::atomic<uint64_t> tail;
+    // the head as last seen by the producer
+    uint64_t cached_head;
+    std::atomic<uint64_t> dropped;
+
+    alignas(64) std::atomic<bool> closed;
+    std::atomic<bool> cancelled;
+    size_t capacity;
+    std::unique_ptr<uint64_t[]> cells;
+
+    inline static thread_local VisitQueue* current = nullptr;
+
+public:
+    /*
+    * @param capacity number of cells the ring holds, rounded up to a power of two
+    */
+    explicit VisitQueue(size_t capacity);
+
+    VisitQueue(const VisitQueue&) = delete;
+    VisitQueue& operator=(const VisitQueue&) = delete;
+
+    /*
+    * Queues a flat cell index (row * width + col), producer only.
+    * @return false if the ring was full and the cell was dropped
+    */
+    bool push(uint64_t cell) {
+        uint64_t position = tail.load(std::memory_order_relaxed);
+        if (position - cached_head == capacity) {
+            cached_head = head.load(std::memory_order_acquire);
+            if (position - cached_head == capacity) {
+                dropped.store(dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+        cells[position & (capacity - 1)] = cell;
+        tail.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    /*
+    * Takes up to max_count queued cells, oldest first, consumer only.
+    * @return number of cells written to out
+    */
+    size_t pop(uint64_t* out, size_t max_count);
+
+    // marks the end of the visits, producer only. Whatever the producer wrote before is visible
+    // to a consumer that sees is_closed()
+    void close();
+
+    bool is_closed() const;
+
+    // closes the queue because the producer failed, producer only. A consumer that sees
+    // is_closed() then also sees is_cancelled()
+    void cancel();
+
+    bool is_cancelled() const;
+
+    // returns number of cells dropped because the ring was full
+    uint64_t get_dropped() const;
+
+    // returns the queue that solvers on the calling thread publish to, or nullptr
+    static VisitQueue* get_current() {
+        return current;
+    }
+
+    // sets the queue that solvers on the calling thread publish to, nullptr stops publishing
+    static void set_current(VisitQueue* queue);
+};
+
+// queues a visited cell on the calling thread's VisitQueue, if it has one
+inline void publish_visit(uint64_t cell) {
+    if (VisitQueue* visits = VisitQueue::get_current()) {
+        visits->push(cell);
+    }
+}
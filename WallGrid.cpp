@@ -0,0 +1,240 @@
+#include "WallGrid.h"
+#include "Instrument.h"
+#include <algorithm>
+#include <assert.h>
+
+using namespace std;
+
+WallGrid::WallGrid() : WallGrid(0, 0) {}
+
+WallGrid::WallGrid(int h, int w) : WallGrid(h, w, Layout::ROW_MAJOR) {}
+
+WallGrid::WallGrid(int h, int w, Layout l)
+    : height(h), width(w), layout(l), tiles_per_row((w + TILE_MASK) >> TILE_SHIFT) {
+    assert(height >= 0);
+    assert(width >= 0);
+    owned_walls = make_unique<uint64_t[]>(get_wall_word_count(height, width, layout));
+    MAZE_COUNT_ALLOCATION(get_wall_word_count(height, width, layout) * sizeof(uint64_t));
+    walls = owned_walls.get();
+    fill_walls();
+}
+
+WallGrid::WallGrid(int h, int w, uint64_t* words, shared_ptr<void> owner)
+    : height(h), width(w), layout(Layout::ROW_MAJOR), tiles_per_row((w + TILE_MASK) >> TILE_SHIFT),
+      walls(words), walls_owner(owner) {
+    assert(height >= 0);
+    assert(width >= 0);
+}
+
+const uint64_t* WallGrid::get_wall_words() const {
+    return walls;
+}
+
+WallGrid::Layout WallGrid::get_layout() const {
+    return layout;
+}
+
+WallGrid WallGrid::copy_walls(Layout target) const {
+    WallGrid copy(height, width, target);
+    for (int row = 0; row < height; ++row) {
+        for (int col = 0; col < width; ++col) {
+            size_t from = get_index(row, col);
+            size_t to = copy.get_index(row, col);
+            uint64_t bits = (walls[from >> 5] >> ((from & 31) << 1)) & 3;
+            copy.walls[to >> 5] &= ~(uint64_t(3) << ((to & 31) << 1));
+            copy.walls[to >> 5] |= bits << ((to & 31) << 1);
+        }
+    }
+    return copy;
+}
+
+bool WallGrid::is_borrowed() const {
+    return !owned_walls;
+}
+
+int WallGrid::get_height() const {
+    return height;
+}
+
+int WallGrid::get_width() const {
+    return width;
+}
+
+size_t WallGrid::get_index(int row, int col) const {
+    assert(row >= 0 && row < height);
+    assert(col >= 0 && col < width);
+    if (layout == Layout::ROW_MAJOR) {
+        return static_cast<size_t>(row) * width + col;
+    }
+    size_t tile = static_cast<size_t>(row >> TILE_SHIFT) * tiles_per_row + (col >> TILE_SHIFT);
+    return tile << (2 * TILE_SHIFT) | (row & TILE_MASK) << TILE_SHIFT | (col & TILE_MASK);
+}
+
+size_t WallGrid::get_slot_count() const {
+    if (layout == Layout::ROW_MAJOR) {
+        return static_cast<size_t>(height) * width;
+    }
+    return static_cast<size_t>((height + TILE_MASK) >> TILE_SHIFT) * tiles_per_row << (2 * TILE_SHIFT);
+}
+
+size_t WallGrid::get_wall_word_count(int height, int width) {
+    return get_wall_word_count(height, width, Layout::ROW_MAJOR);
+}
+
+size_t WallGrid::get_wall_word_count(int height, int width, Layout layout) {
+    // 32 cells of 2 bits each per word
+    if (layout == Layout::ROW_MAJOR) {
+        return (static_cast<size_t>(height) * width + 31) / 32;
+    }
+    // 8 words per tile
+    return static_cast<size_t>((height + TILE_MASK) >> TILE_SHIFT) * ((width + TILE_MASK) >> TILE_SHIFT) * 8;
+}
+
+size_t WallGrid::get_path_plane_word_count() const {
+    return (get_slot_count() + 63) / 64;
+}
+
+void WallGrid::fill_walls() {
+    fill(walls, walls + get_wall_word_count(height, width, layout), ~uint64_t(0));
+    clear_path();
+}
+
+bool WallGrid::get_wall_bit(int row, int col, int bit) const {
+    size_t index = get_index(row, col);
+    return (walls[index >> 5] >> (((index & 31) << 1) + bit)) & 1;
+}
+
+void WallGrid::set_wall_bit(int row, int col, int bit, bool value) {
+    size_t index = get_index(row, col);
+    uint64_t mask = uint64_t(1) << (((index & 31) << 1) + bit);
+    if (value) {
+        walls[index >> 5] |= mask;
+    } else {
+        walls[index >> 5] &= ~mask;
+    }
+}
+
+bool WallGrid::has_east_wall(int row, int col) const {
+    return get_wall_bit(row, col, EAST_BIT);
+}
+
+bool WallGrid::has_south_wall(int row, int col) const {
+    return get_wall_bit(row, col, SOUTH_BIT);
+}
+
+void WallGrid::set_east_wall(int row, int col, bool built) {
+    set_wall_bit(row, col, EAST_BIT, built);
+}
+
+void WallGrid::set_south_wall(int row, int col, bool built) {
+    set_wall_bit(row, col, SOUTH_BIT, built);
+}
+
+// moves the even bits of x into its low 32 bits
+static uint64_t compact_even_bits(uint64_t x) {
+    x &= 0x5555555555555555ULL;
+    x = (x | (x >> 1)) & 0x3333333333333333ULL;
+    x = (x | (x >> 2)) & 0x0F0F0F0F0F0F0F0FULL;
+    x = (x | (x >> 4)) & 0x00FF00FF00FF00FFULL;
+    x = (x | (x >> 8)) & 0x0000FFFF0000FFFFULL;
+    x = (x | (x >> 16)) & 0x00000000FFFFFFFFULL;
+    return x;
+}
+
+void WallGrid::get_row_walls(int row, uint64_t* east_walls, uint64_t* south_walls) const {
+    assert(row >= 0 && row < height);
+    if (layout == Layout::TILED) {
+        // each tile holds the row's 16 cells in one half of a word
+        for (int col = 0; col < width; col += TILE_MASK + 1) {
+            size_t index = get_index(row, col);
+            uint64_t bits = (walls[index >> 5] >> ((index & 31) << 1)) & 0xFFFFFFFFULL;
+            east_walls[col >> 6] |= compact_even_bits(bits >> EAST_BIT) << (col & 63);
+            south_walls[col >> 6] |= compact_even_bits(bits >> SOUTH_BIT) << (col & 63);
+        }
+        return;
+    }
+    size_t word_count = get_wall_word_count(height, width);
+
+    for (int col = 0; col < width; col += 32) {
+        // the 64 bits of cells col..col+31, which may straddle two words
+        size_t bit = 2 * get_index(row, col);
+        size_t word = bit >> 6;
+        int shift = bit & 63;
+        uint64_t bits = walls[word] >> shift;
+        if (shift != 0 && word + 1 < word_count) {
+            bits |= walls[word + 1] << (64 - shift);
+        }
+
+        east_walls[col >> 6] |= compact_even_bits(bits >> EAST_BIT) << (col & 63);
+        south_walls[col >> 6] |= compact_even_bits(bits >> SOUTH_BIT) << (col & 63);
+    }
+}
+
+bool WallGrid::get_path_bit(int row, int col, int plane) const {
+    if (!path) {
+        return false;
+    }
+    size_t index = get_index(row, col);
+    size_t word = plane * get_path_plane_word_count() + (index >> 6);
+    return (path[word] >> (index & 63)) & 1;
+}
+
+void WallGrid::set_path_bit(int row, int col, int plane, bool value) {
+    if (!path) {
+        if (!value) {
+            return;
+        }
+        // zero initialized by make_unique
+        path = make_unique<uint64_t[]>(3 * get_path_plane_word_count());
+        MAZE_COUNT_ALLOCATION(3 * get_path_plane_word_count() * sizeof(uint64_t));
+    }
+    size_t index = get_index(row, col);
+    size_t word = plane * get_path_plane_word_count() + (index >> 6);
+    uint64_t mask = uint64_t(1) << (index & 63);
+    if (value) {
+        path[word] |= mask;
+    } else {
+        path[word] &= ~mask;
+    }
+}
+
+bool WallGrid::is_on_path(int row, int col, int plane) const {
+    assert(plane >= PATH_CELL && plane <= PATH_SOUTH);
+    return get_path_bit(row, col, plane);
+}
+
+void WallGrid::set_on_path(int row, int col, int plane, bool value) {
+    assert(plane >= PATH_CELL && plane <= PATH_SOUTH);
+    set_path_bit(row, col, plane, value);
+}
+
+void WallGrid::clear_path() {
+    path.reset();
+}
+
+size_t WallGrid::get_memory_usage() const {
+    size_t bytes = get_wall_word_count(height, width, layout) * sizeof(uint64_t);
+    if (path) {
+        bytes += 3 * get_path_plane_word_count() * sizeof(uint64_t);
+    }
+    return bytes;
+}
+
+vector<string> get_layout_names() {
+    return {"row-major", "tiled"};
+}
+
+string get_layout_name(WallGrid::Layout layout) {
+    return get_layout_names().at(static_cast<int>(layout));
+}
+
+bool parse_layout(const string& name, WallGrid::Layout& layout) {
+    if (name == "row-major") {
+        layout = WallGrid::Layout::ROW_MAJOR;
+    } else if (name == "tiled") {
+        layout = WallGrid::Layout::TILED;
+    } else {
+        return false;
+    }
+    return true;
+}
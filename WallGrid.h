@@ -0,0 +1,181 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+* Bit-packed storage for the walls of a maze.
+*
+* Only the east (RIGHT) and south (BOTTOM) wall of every cell is stored, two bits
+* per cell. The top and left walls of a cell are the south and east walls of its
+* neighbours, and the top/left borders plus the corner posts never change, so they
+* are implied instead of stored. A 100M cell maze takes 25 MB.
+*
+* Cells that are part of a solution path are tracked in a separate bitset with three
+* planes (cell, east passage, south passage). It is only allocated the first time a
+* path bit is set.
+*
+* The wall words are either owned by the grid or borrowed from memory kept alive by an
+* owner object, e.g. the mapped pages of a maze file.
+*
+* Cells are stored in one of two layouts, see Layout. Both are reached through the same
+* accessors, only get_wall_words() exposes the difference.
+*/
+class WallGrid {
+public:
+    /*
+    * Order of the cells in the wall words and path planes.
+    *
+    * ROW_MAJOR stores cell row * width + col at that index, so a move to the row below lands
+    * width / 4 bytes away, on another cache line (and page, on wide mazes). TILED stores 16x16
+    * cell tiles of 8 words, exactly one 64 byte cache line, in row-major tile order with the
+    * cells row-major inside each tile, so 15 of 16 vertical moves stay on the same line. Tiles
+    * pad the grid to a multiple of 16 cells in both directions.
+    */
+    enum class Layout { ROW_MAJOR, TILED };
+
+private:
+    int height;
+    int width;
+    Layout layout;
+    // number of tiles across a tile row, TILED only
+    int tiles_per_row;
+    uint64_t* walls;
+    std::unique_ptr<uint64_t[]> owned_walls;
+    std::shared_ptr<void> walls_owner;
+    std::unique_ptr<uint64_t[]> path;
+
+    static const int EAST_BIT = 0;
+    static const int SOUTH_BIT = 1;
+
+    // a tile is 1 << TILE_SHIFT cells on a side
+    static constexpr int TILE_SHIFT = 4;
+    static constexpr int TILE_MASK = (1 << TILE_SHIFT) - 1;
+
+    // index of the cell in the flat cell array, in the grid's layout
+    size_t get_index(int row, int col) const;
+
+    // number of cell slots in the flat cell array, padding included
+    size_t get_slot_count() const;
+
+    // number of 64 bit words needed for one plane of path bits
+    size_t get_path_plane_word_count() const;
+
+    bool get_wall_bit(int row, int col, int bit) const;
+    void set_wall_bit(int row, int col, int bit, bool value);
+
+    bool get_path_bit(int row, int col, int plane) const;
+    void set_path_bit(int row, int col, int plane, bool value);
+
+public:
+    static const int PATH_CELL = 0;
+    static const int PATH_EAST = 1;
+    static const int PATH_SOUTH = 2;
+
+    /*
+    * Initializes an empty 0x0 grid.
+    */
+    WallGrid();
+
+    /*
+    * Initializes a grid of the specified size with every wall built.
+    * @param height number of cell rows
+    * @param width number of cell cols
+    */
+    WallGrid(int height, int width);
+
+    /*
+    * Initializes a grid of the specified size and cell layout with every wall built.
+    * @param height number of cell rows
+    * @param width number of cell cols
+    * @param layout order of the cells in memory
+    */
+    WallGrid(int height, int width, Layout layout);
+
+    /*
+    * Initializes a ROW_MAJOR grid over existing wall words without copying them.
+    * @param height number of cell rows
+    * @param width number of cell cols
+    * @param words get_wall_word_count(height, width) words in the layout of get_wall_words()
+    * @param owner keeps the words alive for as long as the grid exists
+    */
+    WallGrid(int height, int width, uint64_t* words, std::shared_ptr<void> owner);
+
+    // number of 64 bit words needed to hold the wall bits of a ROW_MAJOR grid of that size
+    static size_t get_wall_word_count(int height, int width);
+
+    // number of 64 bit words needed to hold the wall bits of a grid of that size and layout
+    static size_t get_wall_word_count(int height, int width, Layout layout);
+
+    /*
+    * Returns the packed wall bits: the cell at index i of the layout uses bits 2 * (i % 32)
+    * (east) and 2 * (i % 32) + 1 (south) of word i / 32. For ROW_MAJOR i is row * width + col,
+    * for TILED it is (tile << 8) | (row % 16) << 4 | col % 16, with tile counted row-major.
+    */
+    const uint64_t* get_wall_words() const;
+
+    Layout get_layout() const;
+
+    // returns a copy of the walls in the given layout, without path bits
+    WallGrid copy_walls(Layout layout) const;
+
+    // returns true if the wall words are borrowed instead of owned by the grid
+    bool is_borrowed() const;
+
+    int get_height() const;
+    int get_width() const;
+
+    // builds every wall and clears all path bits
+    void fill_walls();
+
+    // returns true if the east wall of the cell is built
+    bool has_east_wall(int row, int col) const;
+
+    // returns true if the south wall of the cell is built
+    bool has_south_wall(int row, int col) const;
+
+    void set_east_wall(int row, int col, bool built);
+    void set_south_wall(int row, int col, bool built);
+
+    /*
+    * Extracts the walls of a row as bit rows, 32 cells at a time: bit col % 64 of word col / 64
+    * is set if the east (or south) wall of cell col is built. Bits past the width are
+    * unspecified, in ROW_MAJOR they can hold cells of the next row, so callers must mask them.
+    * @param east_walls (width + 63) / 64 words, zeroed by the caller
+    * @param south_walls (width + 63) / 64 words, zeroed by the caller
+    */
+    void get_row_walls(int row, uint64_t* east_walls, uint64_t* south_walls) const;
+
+    /*
+    * Returns true if the specified part of the cell is on the path.
+    * @param plane one of PATH_CELL, PATH_EAST or PATH_SOUTH
+    */
+    bool is_on_path(int row, int col, int plane) const;
+
+    /*
+    * Marks the specified part of the cell as on or off the path.
+    * @param plane one of PATH_CELL, PATH_EAST or PATH_SOUTH
+    */
+    void set_on_path(int row, int col, int plane, bool value);
+
+    // clears every path bit and releases the path bitset
+    void clear_path();
+
+    // returns number of bytes used by the wall and path bitsets, borrowed walls included
+    size_t get_memory_usage() const;
+};
+
+// returns names accepted by parse_layout, in the order of WallGrid::Layout
+std::vector<std::string> get_layout_names();
+
+// returns the name of a layout, e.g. "tiled"
+std::string get_layout_name(WallGrid::Layout layout);
+
+/*
+* Parses a layout name (row-major or tiled).
+* @return false if the name is not a known layout.
+*/
+bool parse_layout(const std::string& name, WallGrid::Layout& layout);
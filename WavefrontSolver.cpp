@@ -0,0 +1,185 @@
+#include "WavefrontSolver.h"
+#include "Instrument.h"
+#include "VisitQueue.h"
+#include <algorithm>
+
+using namespace std;
+
+using Side = Maze::Side;
+
+// cells of the first / last column and row of a tile
+static const uint64_t FIRST_COL = 0x0101010101010101ULL;
+static const uint64_t LAST_COL = FIRST_COL << 7;
+static const uint64_t FIRST_ROW = 0xFFULL;
+static const uint64_t LAST_ROW = FIRST_ROW << 56;
+
+string WavefrontSolver::get_name() const {
+    return "wavefront";
+}
+
+void WavefrontSolver::prepare(const Maze& maze) {
+    int height = maze.get_height();
+    int width = maze.get_width();
+    int words_per_row = (width + 63) / 64;
+    tiles_per_row = (width + 7) / 8;
+    size_t tile_count = static_cast<size_t>((height + 7) / 8) * tiles_per_row;
+
+    east_open.assign(tile_count, 0);
+    south_open.assign(tile_count, 0);
+    visited.assign(tile_count, 0);
+    reached.assign(tile_count, 0);
+    for (auto& plane : level_planes) {
+        plane.assign(tile_count, 0);
+    }
+    frontier.clear();
+    MAZE_COUNT_ALLOCATION(7 * tile_count * sizeof(uint64_t));
+
+    // past the width or height, on the right border and below the last row nothing is open,
+    // so cells never move out of the maze and expand_tile needs no bounds checks for those moves
+    vector<uint64_t> east_walls(words_per_row);
+    vector<uint64_t> south_walls(words_per_row);
+    int last_col = width - 1;
+
+    for (int row = 0; row < height; ++row) {
+        maze.get_row_walls(row, east_walls.data(), south_walls.data());
+        east_walls[last_col >> 6] |= uint64_t(1) << (last_col & 63);
+        if (row == height - 1) {
+            fill(south_walls.begin(), south_walls.end(), ~uint64_t(0));
+        }
+
+        size_t tile = static_cast<size_t>(row / 8) * tiles_per_row;
+        int shift = 8 * (row % 8);
+        for (int tile_col = 0; tile_col < tiles_per_row; ++tile_col, ++tile) {
+            int word = tile_col / 8;
+            int byte = 8 * (tile_col % 8);
+            east_open[tile] |= ((~east_walls[word] >> byte) & 0xFF) << shift;
+            south_open[tile] |= ((~south_walls[word] >> byte) & 0xFF) << shift;
+        }
+    }
+}
+
+size_t WavefrontSolver::get_tile(pair<int,int> cell, uint64_t& bit) const {
+    bit = uint64_t(1) << (8 * (cell.first % 8) + cell.second % 8);
+    return static_cast<size_t>(cell.first / 8) * tiles_per_row + cell.second / 8;
+}
+
+void WavefrontSolver::reach(size_t tile, uint64_t cells) {
+    if (cells == 0) {
+        return;
+    }
+    if (reached[tile] == 0) {
+        touched_tiles.push_back(tile);
+    }
+    reached[tile] |= cells;
+}
+
+void WavefrontSolver::expand_tile(size_t tile, uint64_t cells) {
+    // east: a cell moves one bit up if its east wall is open, the last column crosses into the next tile
+    uint64_t east = cells & east_open[tile];
+    reach(tile, (east & ~LAST_COL) << 1);
+    reach(tile + 1, (east & LAST_COL) >> 7);
+
+    // west: a cell moves one bit down if the east wall of its west neighbor is open
+    reach(tile, ((cells & ~FIRST_COL) >> 1) & east_open[tile]);
+    if (tile > 0) {
+        reach(tile - 1, ((cells & FIRST_COL) << 7) & east_open[tile - 1]);
+    }
+
+    // south: one row (8 bits) up if the south wall is open, the last row crosses into the tile below
+    uint64_t south = cells & south_open[tile];
+    reach(tile, (south & ~LAST_ROW) << 8);
+    reach(tile + tiles_per_row, (south & LAST_ROW) >> 56);
+
+    // north: one row down if the south wall of the cell above is open
+    reach(tile, ((cells & ~FIRST_ROW) >> 8) & south_open[tile]);
+    if (tile >= static_cast<size_t>(tiles_per_row)) {
+        reach(tile - tiles_per_row, ((cells & FIRST_ROW) << 56) & south_open[tile - tiles_per_row]);
+    }
+}
+
+Path WavefrontSolver::solve(const Maze& maze, pair<int,int> start, pair<int,int> end) {
+    MAZE_PHASE(Phase::SOLVE);
+    nodes_expanded = 0;
+    prepare(maze);
+
+    uint64_t start_bit;
+    size_t start_tile = get_tile(start, start_bit);
+    visited[start_tile] = start_bit;
+    level_planes[0][start_tile] = start_bit;
+    MAZE_COUNT_VISIT(static_cast<size_t>(start.first) * maze.get_width() + start.second);
+    publish_visit(static_cast<size_t>(start.first) * maze.get_width() + start.second);
+    VisitQueue* visits = VisitQueue::get_current();
+    frontier.push_back(make_pair(start_tile, start_bit));
+
+    uint64_t end_bit;
+    size_t end_tile = get_tile(end, end_bit);
+    uint32_t level = 0;
+
+    while (!frontier.empty() && !(visited[end_tile] & end_bit)) {
+        // the whole level is gathered in `reached` before any cell is marked visited
+        touched_tiles.clear();
+        for (auto& tile : frontier) {
+            nodes_expanded += __builtin_popcountll(tile.second);
+            expand_tile(tile.first, tile.second);
+        }
+
+        level++;
+        vector<uint64_t>& plane = level_planes[level % 3];
+        next_frontier.clear();
+        for (size_t tile : touched_tiles) {
+            uint64_t cells = reached[tile] & ~visited[tile];
+            reached[tile] = 0;
+            if (cells) {
+                visited[tile] |= cells;
+                plane[tile] |= cells;
+                next_frontier.push_back(make_pair(tile, cells));
+#ifdef MAZE_INSTRUMENT
+                for (uint64_t bits = cells; bits != 0; bits &= bits - 1) {
+                    int bit = __builtin_ctzll(bits);
+                    size_t row = (tile / tiles_per_row) * 8 + bit / 8;
+                    size_t col = (tile % tiles_per_row) * 8 + bit % 8;
+                    MAZE_COUNT_VISIT(row * maze.get_width() + col);
+                }
+#endif
+                for (uint64_t bits = visits ? cells : 0; bits != 0; bits &= bits - 1) {
+                    int bit = __builtin_ctzll(bits);
+                    size_t row = (tile / tiles_per_row) * 8 + bit / 8;
+                    size_t col = (tile % tiles_per_row) * 8 + bit % 8;
+                    visits->push(row * maze.get_width() + col);
+                }
+            }
+        }
+        frontier.swap(next_frontier);
+        MAZE_TRACK_FRONTIER(frontier.size());
+    }
+
+    if (!(visited[end_tile] & end_bit)) {
+        return Path();
+    }
+    nodes_expanded++;
+
+    // walk back through the level planes, level - 1 is the only neighbor level in plane (level - 1) % 3
+    const Side sides[] = {Side::TOP, Side::RIGHT, Side::BOTTOM, Side::LEFT};
+    Path path(end);
+    pair<int,int> cell = end;
+
+    for (uint32_t step = level; step > 0; --step) {
+        const vector<uint64_t>& previous_plane = level_planes[(step - 1) % 3];
+        for (Side side : sides) {
+            if (!maze.is_passage_open(cell.first, cell.second, side)) {
+                continue;
+            }
+            pair<int,int> neighbor = Path::get_neighbor(cell, Path::Step(side));
+            uint64_t bit;
+            size_t tile = get_tile(neighbor, bit);
+            if (previous_plane[tile] & bit) {
+                cell = neighbor;
+                break;
+            }
+        }
+        path.add(cell);
+    }
+
+    path.reverse();
+    return path;
+}
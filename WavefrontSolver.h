@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Solver.h"
+
+/*
+* Bit-parallel breadth first search.
+*
+* The maze is split into tiles of 8x8 cells, each a 64 bit word of the open-passage and visited
+* bit sets (bit 8 * row + col within the tile). A BFS level moves all frontier cells of a tile at
+* once with shifts and masks, and only tiles the frontier reaches are touched. Square tiles keep
+* the speedup for fronts in any direction: a diagonal front, as seen in open grids, still puts
+* around 8 cells in every tile it crosses, where a row of 64 cells would hold only one.
+*
+* Instead of parents, the BFS level of each cell is kept modulo 3 as three bit planes. Neighbors
+* differ by at most one level, so the previous cell of the path is the open neighbor in the plane
+* of level - 1, and the path is traced back from the end without storing any per-cell index.
+*/
+class WavefrontSolver : public Solver {
+    int tiles_per_row;
+    std::vector<uint64_t> east_open;
+    std::vector<uint64_t> south_open;
+    std::vector<uint64_t> visited;
+    std::vector<uint64_t> reached;
+    std::vector<uint64_t> level_planes[3];
+    std::vector<size_t> touched_tiles;
+    std::vector<std::pair<size_t, uint64_t>> frontier;
+    std::vector<std::pair<size_t, uint64_t>> next_frontier;
+
+    // resizes and clears the bit sets and fills the open-passage masks from the maze
+    void prepare(const Maze& maze);
+
+    // returns the tile of a cell and sets bit to the cell's bit in it
+    size_t get_tile(std::pair<int,int> cell, uint64_t& bit) const;
+
+    // ors cells into the reached bits of a tile, remembering which tiles were touched
+    void reach(size_t tile, uint64_t cells);
+
+    // moves the frontier cells of a tile one step in every open direction
+    void expand_tile(size_t tile, uint64_t cells);
+
+public:
+    std::string get_name() const override;
+    Path solve(const Maze& maze, std::pair<int,int> start, std::pair<int,int> end) override;
+};
@@ -0,0 +1,454 @@
+#include <algorithm>
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "FixedMaze.h"
+#include "Maze.h"
+#include "Report.h"
+#include "Solver.h"
+#include "ParallelBFSSolver.h"
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+/*
+* Benchmarks the generators and solvers on square mazes from 10x10 up to 10k x 10k
+* and writes the cells/sec of each run as CSV or JSON to stdout.
+*
+* The parallel BFS solver runs once per --threads count, and its speedup over the first count
+* on the same maze is summarized on stderr.
+*
+* With several --layout names every maze is generated once per wall layout, and the time and
+* cache misses of each generate and solve are compared with the first layout on stderr.
+*
+* --fixed instead compares FixedMaze with Maze on small sizes, see benchmark_fixed_maze.
+*/
+
+const vector<int> BENCHMARK_SIZES{10, 100, 1000, 10000};
+
+/*
+* Counts one hardware event on the calling thread with perf_event_open. Where the kernel doesn't
+* allow it (other systems, containers, a high perf_event_paranoid) it is unavailable and reads 0.
+* Threads started by a solver are not counted.
+*/
+class PerfCounter {
+    int fd;
+
+public:
+    PerfCounter(uint32_t type, uint64_t config) : fd(-1) {
+#ifdef __linux__
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+    }
+
+    ~PerfCounter() {
+#ifdef __linux__
+        if (fd >= 0) {
+            close(fd);
+        }
+#endif
+    }
+
+    PerfCounter(const PerfCounter&) = delete;
+    PerfCounter& operator=(const PerfCounter&) = delete;
+
+    bool is_available() const {
+        return fd >= 0;
+    }
+
+    void start() {
+#ifdef __linux__
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    // stops counting and returns the events since start()
+    uint64_t stop() {
+        uint64_t count = 0;
+#ifdef __linux__
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(fd, &count, sizeof(count)) != sizeof(count)) {
+                count = 0;
+            }
+        }
+#endif
+        return count;
+    }
+};
+
+/*
+* Cache and TLB misses of one measured section, see PerfCounter.
+*/
+class CacheMissCounters {
+#ifdef __linux__
+    PerfCounter l1d{PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | PERF_COUNT_HW_CACHE_OP_READ << 8
+        | PERF_COUNT_HW_CACHE_RESULT_MISS << 16};
+    PerfCounter last_level{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES};
+    PerfCounter dtlb{PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | PERF_COUNT_HW_CACHE_OP_READ << 8
+        | PERF_COUNT_HW_CACHE_RESULT_MISS << 16};
+#else
+    PerfCounter l1d{0, 0};
+    PerfCounter last_level{0, 0};
+    PerfCounter dtlb{0, 0};
+#endif
+
+public:
+    uint64_t l1d_misses = 0;
+    uint64_t last_level_misses = 0;
+    uint64_t dtlb_misses = 0;
+
+    bool is_available() const {
+        return l1d.is_available() || last_level.is_available() || dtlb.is_available();
+    }
+
+    void start() {
+        l1d.start();
+        last_level.start();
+        dtlb.start();
+    }
+
+    void stop() {
+        l1d_misses = l1d.stop();
+        last_level_misses = last_level.stop();
+        dtlb_misses = dtlb.stop();
+    }
+
+    // writes the counts, or that they couldn't be measured
+    void write(ostream& out) const {
+        if (!is_available()) {
+            out << "misses n/a";
+            return;
+        }
+        out << "L1d misses " << l1d_misses << ", LLC misses " << last_level_misses
+            << ", dTLB misses " << dtlb_misses;
+    }
+};
+
+void print_usage(const char* program) {
+    cerr << "Usage: " << program << " [options]\n"
+         << "  --min-size N       skip sizes below N (default 10)\n"
+         << "  --max-size N       skip sizes above N (default 10000)\n"
+         << "  --repeat N         runs per size, each with the next seed (default 3)\n"
+         << "  --seed N           seed of the first run (default 1)\n"
+         << "  --generator NAME   only run this generator: dfs, kruskal, prim, aldous-broder or eller (default all)\n"
+         << "  --solver NAME      only run this solver: dfs, bfs, bibfs, astar, wavefront, pbfs, lpastar or tree (default all)\n"
+         << "  --threads LIST     comma separated thread counts for pbfs (default 1 and every hardware thread)\n"
+         << "  --layout LIST      comma separated wall layouts to compare: row-major, tiled (default row-major)\n"
+         << "  --fixed            compare FixedMaze with Maze at 16x16, 32x32 and 64x64 (Prim and BFS) instead\n"
+         << "  --format FORMAT    report format: csv or json (default csv)\n";
+}
+
+// splits "a,b,c" into its items
+vector<string> split_list(const string& list) {
+    vector<string> items;
+    size_t begin = 0;
+    while (begin <= list.size()) {
+        size_t end = list.find(',', begin);
+        if (end == string::npos) {
+            end = list.size();
+        }
+        items.push_back(list.substr(begin, end - begin));
+        begin = end + 1;
+    }
+    return items;
+}
+
+// parses "1,2,4" into its numbers
+vector<int> parse_thread_counts(const string& list) {
+    vector<int> counts;
+    for (const string& item : split_list(list)) {
+        counts.push_back(stoi(item));
+    }
+    return counts;
+}
+
+// generate and solve rounds each small maze timing is averaged over
+const int FIXED_MAZE_ROUNDS = 1000;
+
+/*
+* Generates and solves a FixedMaze<W,H> and a Maze of the same size from the seed with Prim and
+* BFS, FIXED_MAZE_ROUNDS times each, and appends the average times of both as records.
+* @return false if the two mazes' paths differ in length
+*/
+template <int W, int H>
+bool benchmark_fixed_maze(unsigned long long seed, BFSSolver& solver, vector<RunRecord>& records) {
+    // keeps the compiler from dropping mazes that are never read
+    size_t checksum = 0;
+
+    auto fixed_generate_start = chrono::steady_clock::now();
+    for (int round = 0; round < FIXED_MAZE_ROUNDS; ++round) {
+        FixedMaze<W, H> maze(seed);
+        checksum += maze.has_east_wall(0, 0);
+    }
+    auto fixed_generate_end = chrono::steady_clock::now();
+
+    FixedMaze<W, H> fixed_maze(seed);
+    size_t fixed_length = 0;
+    auto fixed_solve_start = chrono::steady_clock::now();
+    for (int round = 0; round < FIXED_MAZE_ROUNDS; ++round) {
+        fixed_length = fixed_maze.solve(fixed_maze.get_start_location(), fixed_maze.get_end_location()).size();
+    }
+    auto fixed_solve_end = chrono::steady_clock::now();
+
+    auto generate_start = chrono::steady_clock::now();
+    for (int round = 0; round < FIXED_MAZE_ROUNDS; ++round) {
+        Maze maze(W, H, seed, Maze::Generator::PRIM);
+        checksum += maze.get_width();
+    }
+    auto generate_end = chrono::steady_clock::now();
+
+    Maze maze(W, H, seed, Maze::Generator::PRIM);
+    size_t length = 0;
+    auto solve_start = chrono::steady_clock::now();
+    for (int round = 0; round < FIXED_MAZE_ROUNDS; ++round) {
+        length = solver.solve(maze, maze.get_start_location(), maze.get_end_location()).size();
+    }
+    auto solve_end = chrono::steady_clock::now();
+
+    RunRecord record;
+    record.generator = "prim";
+    record.width = W;
+    record.height = H;
+    record.seed = seed;
+
+    record.solver = "fixed-bfs";
+    record.generate_seconds = chrono::duration<double>(fixed_generate_end - fixed_generate_start).count() / FIXED_MAZE_ROUNDS;
+    record.solve_seconds = chrono::duration<double>(fixed_solve_end - fixed_solve_start).count() / FIXED_MAZE_ROUNDS;
+    record.path_length = fixed_length;
+    records.push_back(record);
+    double fixed_solve_seconds = record.solve_seconds;
+
+    record.solver = solver.get_name();
+    record.generate_seconds = chrono::duration<double>(generate_end - generate_start).count() / FIXED_MAZE_ROUNDS;
+    record.solve_seconds = chrono::duration<double>(solve_end - solve_start).count() / FIXED_MAZE_ROUNDS;
+    record.path_length = length;
+    record.nodes_expanded = solver.get_nodes_expanded();
+    records.push_back(record);
+
+    cerr << "fixed " << W << "x" << H << " seed " << seed << " solve speedup over Maze "
+         << record.solve_seconds / fixed_solve_seconds << " (checksum " << checksum << ")" << endl;
+    if (fixed_length != length) {
+        cerr << "FixedMaze path of " << fixed_length << " cells differs from Maze path of " << length << endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    int min_size = 10;
+    int max_size = 10000;
+    int repeat = 3;
+    unsigned long long seed = 1;
+    vector<string> generator_names = get_generator_names();
+    vector<string> solver_names = get_solver_names();
+    vector<int> thread_counts{1, max(1, static_cast<int>(thread::hardware_concurrency()))};
+    vector<string> layout_names{"row-major"};
+    bool fixed = false;
+    ReportFormat format = ReportFormat::CSV;
+
+    // stoi and friends throw on values that are not numbers or out of range
+    try {
+        for (int i = 1; i < argc; ++i) {
+            bool has_value = i + 1 < argc;
+            if (strcmp(argv[i], "--min-size") == 0 && has_value) {
+                min_size = stoi(argv[++i]);
+            } else if (strcmp(argv[i], "--max-size") == 0 && has_value) {
+                max_size = stoi(argv[++i]);
+            } else if (strcmp(argv[i], "--repeat") == 0 && has_value) {
+                repeat = stoi(argv[++i]);
+            } else if (strcmp(argv[i], "--seed") == 0 && has_value) {
+                seed = stoull(argv[++i]);
+            } else if (strcmp(argv[i], "--generator") == 0 && has_value) {
+                generator_names = {argv[++i]};
+            } else if (strcmp(argv[i], "--solver") == 0 && has_value) {
+                solver_names = {argv[++i]};
+            } else if (strcmp(argv[i], "--threads") == 0 && has_value) {
+                thread_counts = parse_thread_counts(argv[++i]);
+            } else if (strcmp(argv[i], "--layout") == 0 && has_value) {
+                layout_names = split_list(argv[++i]);
+            } else if (strcmp(argv[i], "--fixed") == 0) {
+                fixed = true;
+            } else if (strcmp(argv[i], "--format") == 0 && has_value) {
+                if (!parse_report_format(argv[++i], format)) {
+                    cerr << "Unknown format " << argv[i] << endl;
+                    return 1;
+                }
+            } else {
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+    } catch (const logic_error&) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    if (fixed) {
+        BFSSolver solver;
+        vector<RunRecord> records;
+        for (int run = 0; run < repeat; ++run) {
+            if (!benchmark_fixed_maze<16, 16>(seed + run, solver, records)
+                || !benchmark_fixed_maze<32, 32>(seed + run, solver, records)
+                || !benchmark_fixed_maze<64, 64>(seed + run, solver, records)) {
+                return 1;
+            }
+        }
+        write_report(cout, records, format);
+        return 0;
+    }
+
+    // solvers keep their workspace, so each is reused across every maze of a size
+    vector<unique_ptr<Solver>> solvers;
+    vector<int> solver_threads;
+    for (const auto& name : solver_names) {
+        if (name == "pbfs") {
+            for (int threads : thread_counts) {
+                solvers.push_back(make_unique<ParallelBFSSolver>(threads));
+                solver_threads.push_back(threads);
+            }
+            continue;
+        }
+        solvers.push_back(make_solver(name));
+        solver_threads.push_back(1);
+        if (!solvers.back()) {
+            cerr << "Unknown solver " << name << endl;
+            return 1;
+        }
+    }
+
+    vector<Maze::Generator> generators;
+    for (const auto& name : generator_names) {
+        Maze::Generator generator;
+        if (!parse_generator(name, generator)) {
+            cerr << "Unknown generator " << name << endl;
+            return 1;
+        }
+        generators.push_back(generator);
+    }
+
+    vector<WallGrid::Layout> layouts;
+    for (const auto& name : layout_names) {
+        WallGrid::Layout layout;
+        if (!parse_layout(name, layout)) {
+            cerr << "Unknown layout " << name << endl;
+            return 1;
+        }
+        layouts.push_back(layout);
+    }
+    bool compare_layouts = layouts.size() > 1;
+    CacheMissCounters misses;
+
+    vector<RunRecord> records;
+
+    for (size_t g = 0; g < generators.size(); ++g) {
+        for (int size : BENCHMARK_SIZES) {
+            if (size < min_size || size > max_size) {
+                continue;
+            }
+            for (int run = 0; run < repeat; ++run) {
+                unsigned long long run_seed = seed + run;
+                // times of the first layout, which the others are compared with
+                double base_generate_seconds = 0;
+                vector<double> base_solve_seconds(solvers.size());
+
+                for (size_t l = 0; l < layouts.size(); ++l) {
+                    misses.start();
+                    auto generate_start = chrono::steady_clock::now();
+                    Maze maze = Maze(size, size, run_seed, generators[g], false, layouts[l]);
+                    auto generate_end = chrono::steady_clock::now();
+                    misses.stop();
+                    double generate_seconds = chrono::duration<double>(generate_end - generate_start).count();
+
+                    if (compare_layouts) {
+                        if (l == 0) {
+                            base_generate_seconds = generate_seconds;
+                        }
+                        cerr << "layout " << layout_names[l] << " " << size << "x" << size << " seed " << run_seed
+                             << " generate " << generator_names[g] << " " << generate_seconds << " s ("
+                             << base_generate_seconds / generate_seconds << "x the speed of " << layout_names[0] << "), ";
+                        misses.write(cerr);
+                        cerr << endl;
+                    }
+
+                    double parallel_base_seconds = 0;
+                    for (size_t s = 0; s < solvers.size(); ++s) {
+                        auto& solver = solvers[s];
+                        RunRecord record;
+                        record.generator = generator_names[g];
+                        record.solver = solver->get_name();
+                        record.threads = solver_threads[s];
+                        record.layout = layout_names[l];
+                        record.width = size;
+                        record.height = size;
+                        record.seed = run_seed;
+                        record.generate_seconds = generate_seconds;
+
+                        // the tree solver gets its own maze that records the spanning tree, so only
+                        // its generate time includes the recording
+                        unique_ptr<Maze> tree_maze;
+                        if (record.solver == "tree") {
+                            auto tree_start = chrono::steady_clock::now();
+                            tree_maze = make_unique<Maze>(size, size, run_seed, generators[g], true, layouts[l]);
+                            auto tree_end = chrono::steady_clock::now();
+                            record.generate_seconds = chrono::duration<double>(tree_end - tree_start).count();
+                        }
+                        const Maze& solve_maze = tree_maze ? *tree_maze : maze;
+
+                        misses.start();
+                        auto solve_start = chrono::steady_clock::now();
+                        Path path = solver->solve(solve_maze, solve_maze.get_start_location(), solve_maze.get_end_location());
+                        auto solve_end = chrono::steady_clock::now();
+                        misses.stop();
+
+                        record.solve_seconds = chrono::duration<double>(solve_end - solve_start).count();
+                        record.path_length = path.size();
+                        record.nodes_expanded = solver->get_nodes_expanded();
+                        records.push_back(record);
+
+                        if (compare_layouts) {
+                            if (l == 0) {
+                                base_solve_seconds[s] = record.solve_seconds;
+                            }
+                            cerr << "layout " << layout_names[l] << " " << size << "x" << size << " seed " << run_seed
+                                 << " solve " << record.solver << " " << record.solve_seconds << " s ("
+                                 << base_solve_seconds[s] / record.solve_seconds << "x the speed of " << layout_names[0] << "), ";
+                            misses.write(cerr);
+                            cerr << endl;
+                        }
+
+                        if (record.solver == "pbfs") {
+                            if (parallel_base_seconds == 0) {
+                                parallel_base_seconds = record.solve_seconds;
+                            }
+                            cerr << "pbfs " << size << "x" << size << " seed " << run_seed
+                                 << " threads " << record.threads
+                                 << " speedup " << parallel_base_seconds / record.solve_seconds << endl;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    write_report(cout, records, format);
+}
@@ -1,11 +1,755 @@
+#include <algorithm>
 #include <iostream>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <stdexcept>
+#include <thread>
+#include "BatchService.h"
+#include "DistanceField.h"
+#include "EllerGenerator.h"
+#include "HPAIndex.h"
+#include "ImageExport.h"
+#include "Instrument.h"
+#include "LPAStarSolver.h"
 #include "Maze.h"
+#include "MazeArchive.h"
+#include "MazeFile.h"
+#include "MazeRenderer.h"
+#include "Report.h"
+#include "Solver.h"
+#include "TiledMaze.h"
+#include "ThreadPool.h"
+#include "TiledSolver.h"
+#include "VisitQueue.h"
 using namespace std;
 
-int main() {
-    cout << "Hello world" << endl;
-    Maze maze = Maze(30,20);
-    // maze.display_maze();
-    maze.solveMazeDFS();
-    maze.display_maze();
+#ifdef MAZE_INSTRUMENT
+// events kept by --trace, the oldest are dropped beyond this
+static const size_t TRACE_CAPACITY = 1 << 22;
+#endif
+
+// visits --display can fall behind by before the solver drops some
+static const size_t VISIT_QUEUE_CAPACITY = 1 << 20;
+
+// walls --ticks toggles per tick unless --edits says otherwise
+static const int DEFAULT_EDITS_PER_TICK = 16;
+
+// memory for the tile caches of --tiled unless --memory-mb says otherwise
+static const size_t DEFAULT_TILED_MEMORY_MB = 1024;
+
+void print_usage(const char* program) {
+    cerr << "Usage: " << program << " [options]\n"
+         << "  --width N          maze width (default 30)\n"
+         << "  --height N         maze height (default 20)\n"
+         << "  --seed N           seed for generation (default: random)\n"
+         << "  --generator NAME   generation algorithm: dfs, kruskal, prim, aldous-broder or eller (default dfs)\n"
+         << "  --solver NAME      solving algorithm: dfs, bfs, bibfs, astar, wavefront, pbfs, lpastar or tree (default dfs)\n"
+         << "  --layout NAME      order of the walls in memory: row-major or tiled (default row-major)\n"
+         << "  --format FORMAT    report format: csv or json (default csv)\n"
+         << "  --display          show the solve live with ncurses, then its path, instead of a report\n"
+         << "  --stream FILE      stream an eller maze row by row to FILE without solving,\n"
+         << "                     as a binary maze file if FILE ends in .maze, a tiled maze file if it ends\n"
+         << "                     in .tiles, otherwise as text\n"
+         << "  --save FILE        save the generated maze as a binary maze file\n"
+         << "  --load FILE        map a binary maze file instead of generating a maze\n"
+         << "  --braid F          remove each inner wall of the generated maze with probability F, adding loops\n"
+         << "  --queries N        build a hierarchical index and time N path queries between random cells,\n"
+         << "                     then toggle --edits walls and time updating the index against a rebuild\n"
+         << "  --agents N         build a distance field from the exit and walk N agents from random cells to it\n"
+         << "  --field FILE       load the distance field of --agents from FILE, or build and save it there\n"
+         << "                     if FILE is missing or was saved for a different maze\n"
+         << "  --ticks N          toggle --edits random walls N times and re-solve with LPA* after each,\n"
+         << "                     timed against a fresh solve\n"
+         << "  --edits N          walls toggled per tick of --ticks and by --queries (default 16)\n"
+         << "  --tiled FILE       solve a tiled maze file out of core with depth first search\n"
+         << "  --memory-mb N      memory for the cached tiles of --tiled (default 1024), the search stack\n"
+         << "                     of a quarter byte per cell on the current branch comes on top\n"
+         << "  --scratch DIR      directory for the visited bits of --tiled (default: the directory of FILE)\n"
+         << "  --batch FILE       generate and solve every job in FILE, one \"width height seed generator solver\"\n"
+         << "                     per line, and report each of them\n"
+         << "  --threads N        worker threads for --batch and --archive (default: one per core)\n"
+         << "  --archive FILE     generate --count mazes with seeds from --seed on and append them to a\n"
+         << "                     compressed maze archive in seed order, then print its compression ratio and\n"
+         << "                     decode speed\n"
+         << "  --count N          mazes appended by --archive (default 1)\n"
+         << "  --extract I        solve maze I of the --archive file instead of generating one\n"
+         << "  --image FILE       write the solved maze as an image, - writes it to stdout instead of the report\n"
+         << "  --image-format F   pbm, pgm or png (default: from the extension of FILE, png for -)\n"
+         << "  --trace FILE       write the last visit events of generation and solving as CSV to FILE,\n"
+         << "                     needs a build with -DMAZE_INSTRUMENT\n";
+}
+
+/*
+* Writes the maze and its path as an image to the file, or to stdout for "-".
+* Throws std::runtime_error if the file can't be written.
+*/
+void export_image(const Maze& maze, const string& filename, ImageFormat format) {
+    if (filename == "-") {
+        write_maze_image(maze, cout, format);
+        cout.flush();
+        return;
+    }
+
+    ofstream out(filename, ios::binary);
+    if (!out) {
+        throw runtime_error("Could not open " + filename);
+    }
+    write_maze_image(maze, out, format);
+    out.close();
+    if (!out) {
+        throw runtime_error("Could not write " + filename);
+    }
+}
+
+/*
+* Runs the jobs of a batch file in parallel and writes one record per job.
+* Throws std::invalid_argument if the file can't be read or has invalid jobs.
+*/
+void run_batch(const string& filename, int threads, ReportFormat format) {
+    ifstream in(filename);
+    if (!in) {
+        throw invalid_argument("Could not open " + filename);
+    }
+    vector<BatchJob> jobs = parse_batch_jobs(in);
+
+    BatchService service(threads);
+    vector<BatchResult> results = service.run(jobs);
+
+    vector<RunRecord> records;
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        if (!results[i].error.empty()) {
+            cerr << "Job " << i << " failed: " << results[i].error << endl;
+            continue;
+        }
+        RunRecord record;
+        record.generator = get_generator_name(jobs[i].generator);
+        record.solver = jobs[i].solver;
+        record.width = jobs[i].width;
+        record.height = jobs[i].height;
+        record.seed = jobs[i].seed;
+        record.generate_seconds = results[i].generate_seconds;
+        record.solve_seconds = results[i].solve_seconds;
+        record.path_length = results[i].path.size();
+        record.nodes_expanded = results[i].nodes_expanded;
+        records.push_back(record);
+    }
+    write_report(cout, records, format);
+}
+
+bool ends_with(const string& s, const string& suffix) {
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+/*
+* Streams an eller maze to the file row by row, memory stays proportional to the width.
+* Throws std::runtime_error if the file can't be written.
+*/
+void stream_eller_maze(const string& filename, int width, int height, unsigned long long seed) {
+    EllerGenerator eller(width, height, seed);
+
+    if (ends_with(filename, ".tiles")) {
+        TiledMazeHeader header = make_tiled_maze_header(width, height);
+        header.seed = seed;
+        header.generator = static_cast<uint32_t>(Maze::Generator::ELLER);
+        TiledMazeWriter writer(filename, header);
+        vector<uint8_t> walls;
+        while (eller.has_next_row()) {
+            eller.next_row(walls);
+            writer.write_row(walls);
+        }
+        writer.close();
+        return;
+    }
+
+    if (ends_with(filename, ".maze")) {
+        MazeFileHeader header = make_maze_file_header(width, height);
+        header.seed = seed;
+        header.generator = static_cast<uint32_t>(Maze::Generator::ELLER);
+        MazeFileWriter writer(filename, header);
+        vector<uint8_t> walls;
+        while (eller.has_next_row()) {
+            eller.next_row(walls);
+            writer.write_row(walls);
+        }
+        writer.close();
+        return;
+    }
+
+    ofstream out(filename);
+    if (!out) {
+        throw runtime_error("Could not open " + filename);
+    }
+    write_ascii_maze(eller, out);
+    out.close();
+    if (!out) {
+        throw runtime_error("Could not write " + filename);
+    }
+}
+
+/*
+* Generates count mazes with consecutive seeds on a thread pool and appends them to an archive,
+* then decodes the whole archive. Sizes and timings go to stderr.
+* Throws std::runtime_error if the archive can't be read or written.
+*/
+void append_to_archive(const string& filename, int count, int width, int height, unsigned long long seed,
+    Maze::Generator generator, int threads) {
+    auto append_start = chrono::steady_clock::now();
+    {
+        MazeArchiveWriter writer(filename);
+        ThreadPool pool(threads);
+        vector<string> errors(count);
+        // positions are reserved in seed order, so the mazes keep that order whichever finishes first
+        vector<size_t> positions(count);
+        for (int i = 0; i < count; ++i) {
+            positions[i] = writer.reserve();
+        }
+        for (int i = 0; i < count; ++i) {
+            pool.submit([&, i](int) {
+                // tasks must not throw, the first error is reported after the pool is done
+                try {
+                    writer.append(Maze(width, height, seed + i, generator), positions[i]);
+                } catch (const exception& error) {
+                    errors[i] = error.what();
+                }
+            });
+        }
+        pool.wait();
+        for (const string& error : errors) {
+            if (!error.empty()) {
+                throw runtime_error(error);
+            }
+        }
+        writer.close();
+    }
+    auto append_end = chrono::steady_clock::now();
+
+    MazeArchive archive(filename);
+    uint64_t raw_bytes = 0;
+    uint64_t compressed_bytes = 0;
+    uint64_t cells = 0;
+    uint64_t grid_bytes = 0;
+    for (size_t i = 0; i < archive.get_maze_count(); ++i) {
+        raw_bytes += archive.get_raw_size(i);
+        compressed_bytes += archive.get_compressed_size(i);
+    }
+    auto decode_start = chrono::steady_clock::now();
+    for (size_t i = 0; i < archive.get_maze_count(); ++i) {
+        Maze maze = archive.get_maze(i);
+        cells += static_cast<uint64_t>(maze.get_width()) * maze.get_height();
+        // a raw grid holds walls, posts and cells at one byte each
+        grid_bytes += static_cast<uint64_t>(2 * maze.get_width() + 1) * (2 * maze.get_height() + 1);
+    }
+    auto decode_end = chrono::steady_clock::now();
+
+    double decode_seconds = max(chrono::duration<double>(decode_end - decode_start).count(), 1e-9);
+    cerr << "archive: appended " << count << " mazes in " << chrono::duration<double>(append_end - append_start).count()
+         << " s, " << archive.get_maze_count() << " mazes in " << filename << "\n"
+         << "archive: " << compressed_bytes << " bytes of coded walls, " << max<double>(raw_bytes, 1) / max<double>(compressed_bytes, 1)
+         << "x smaller than packed wall bits, " << max<double>(grid_bytes, 1) / max<double>(compressed_bytes, 1)
+         << "x smaller than a raw grid, " << compressed_bytes * 8.0 / max<double>(cells, 1) << " bits per cell\n"
+         << "archive: decoded " << archive.get_maze_count() / decode_seconds << " mazes/s, "
+         << cells / decode_seconds / 1e6 << " M cells/s" << endl;
+}
+
+/*
+* Solves the maze on this thread while a MazeRenderer on another thread shows the cells visited
+* as they come in, then the path. Returns once the window is closed.
+*/
+void watch_solve(Maze& maze, Solver& solver) {
+    VisitQueue visits(VISIT_QUEUE_CAPACITY);
+    MazeRenderer renderer(maze);
+    thread render_thread([&renderer, &visits] { renderer.watch(visits); });
+
+    VisitQueue::set_current(&visits);
+    try {
+        maze.set_path(solver.solve(maze, maze.get_start_location(), maze.get_end_location()));
+    } catch (...) {
+        // the renderer quits and restores the terminal before the error is reported
+        VisitQueue::set_current(nullptr);
+        visits.cancel();
+        render_thread.join();
+        throw;
+    }
+    VisitQueue::set_current(nullptr);
+    visits.close();
+    render_thread.join();
+}
+
+/*
+* Builds or removes count random inner walls, each the opposite of what it was.
+*/
+void toggle_random_walls(Maze& maze, int count, Random& random) {
+    for (int i = 0; i < count; ++i) {
+        int row = random.next_below(maze.get_height());
+        int col = random.next_below(maze.get_width());
+        Maze::Side side = random.next_below(2) ? Maze::Side::RIGHT : Maze::Side::BOTTOM;
+        if (maze.has_neighbor(row, col, side)) {
+            maze.set_wall(row, col, side, maze.is_passage_open(row, col, side));
+        }
+    }
+}
+
+/*
+* Builds an HPAIndex of the maze and times path queries between random cells. Then toggles
+* edit_count random walls and times update() against building the index again. Timings go to
+* stderr. Throws std::runtime_error if the updated and the rebuilt index disagree on a distance.
+*/
+void run_queries(Maze& maze, int query_count, int edit_count, uint64_t seed) {
+    auto build_start = chrono::steady_clock::now();
+    HPAIndex index(maze);
+    auto build_end = chrono::steady_clock::now();
+
+    Random random(seed);
+    size_t total_length = 0;
+    for (int i = 0; i < query_count; ++i) {
+        pair<int,int> from(random.next_below(maze.get_height()), random.next_below(maze.get_width()));
+        pair<int,int> to(random.next_below(maze.get_height()), random.next_below(maze.get_width()));
+        total_length += index.get_path(from, to).size();
+    }
+    auto queries_end = chrono::steady_clock::now();
+
+    cerr << "hpa index: " << chrono::duration<double>(build_end - build_start).count() << " s to build, "
+         << index.get_entrance_count() << " entrances, "
+         << chrono::duration<double>(queries_end - build_end).count() / max(query_count, 1) * 1e6
+         << " us per query, " << total_length / max(query_count, 1) << " cells per path" << endl;
+
+    if (edit_count <= 0) {
+        return;
+    }
+    toggle_random_walls(maze, edit_count, random);
+    auto update_start = chrono::steady_clock::now();
+    index.update();
+    auto update_end = chrono::steady_clock::now();
+    HPAIndex rebuilt(maze);
+    auto rebuild_end = chrono::steady_clock::now();
+
+    for (int i = 0; i < query_count; ++i) {
+        pair<int,int> from(random.next_below(maze.get_height()), random.next_below(maze.get_width()));
+        pair<int,int> to(random.next_below(maze.get_height()), random.next_below(maze.get_width()));
+        if (index.get_distance(from, to) != rebuilt.get_distance(from, to)) {
+            throw runtime_error("Updated HPA index disagrees with a rebuilt one after " + to_string(edit_count) + " edits");
+        }
+    }
+    cerr << "hpa update: " << edit_count << " walls toggled, "
+         << chrono::duration<double>(update_end - update_start).count() * 1e3 << " ms to update, "
+         << chrono::duration<double>(rebuild_end - update_end).count() * 1e3 << " ms to rebuild" << endl;
+}
+
+/*
+* Toggles edit_count random walls per tick. After every tick LPA* repairs its last search, and a
+* fresh LPA* solves from scratch for comparison. Average times go to stderr.
+* Throws std::runtime_error if the repaired path is not as short as the fresh one.
+*/
+void run_ticks(Maze& maze, int tick_count, int edit_count, uint64_t seed) {
+    pair<int,int> start = maze.get_start_location();
+    pair<int,int> end = maze.get_end_location();
+    LPAStarSolver repairing;
+    repairing.solve(maze, start, end);
+
+    Random random(seed);
+    double repair_seconds = 0;
+    double fresh_seconds = 0;
+    size_t repair_expanded = 0;
+    size_t fresh_expanded = 0;
+    for (int tick = 0; tick < tick_count; ++tick) {
+        toggle_random_walls(maze, edit_count, random);
+
+        auto repair_start = chrono::steady_clock::now();
+        Path repaired = repairing.solve(maze, start, end);
+        auto repair_end = chrono::steady_clock::now();
+        repair_expanded += repairing.get_nodes_expanded();
+
+        LPAStarSolver fresh;
+        auto fresh_start = chrono::steady_clock::now();
+        Path solved = fresh.solve(maze, start, end);
+        auto fresh_end = chrono::steady_clock::now();
+        fresh_expanded += fresh.get_nodes_expanded();
+
+        repair_seconds += chrono::duration<double>(repair_end - repair_start).count();
+        fresh_seconds += chrono::duration<double>(fresh_end - fresh_start).count();
+        if (repaired.size() != solved.size()) {
+            throw runtime_error("LPA* repaired a path of " + to_string(repaired.size()) + " cells at tick "
+                + to_string(tick) + ", a fresh solve found " + to_string(solved.size()));
+        }
+    }
+
+    int ticks = max(tick_count, 1);
+    cerr << "ticks: " << edit_count << " walls toggled per tick, repair " << repair_seconds / ticks * 1e6
+         << " us and " << repair_expanded / ticks << " cells per tick, fresh solve " << fresh_seconds / ticks * 1e6
+         << " us and " << fresh_expanded / ticks << " cells" << endl;
+}
+
+/*
+* Gets the distance field towards the exit of the maze, loaded from field_file if it was saved for
+* these walls, otherwise built and saved there. Places agents on random cells and steps every one
+* of them to the exit through the field. Timings go to stderr.
+* Throws std::runtime_error if the field can't be saved.
+*/
+void run_agents(const Maze& maze, int agent_count, const string& field_file, uint64_t seed) {
+    auto build_start = chrono::steady_clock::now();
+    unique_ptr<DistanceField> field;
+    bool loaded = false;
+    if (!field_file.empty()) {
+        try {
+            field.reset(new DistanceField(DistanceField::load(field_file, maze)));
+            loaded = field->get_target() == maze.get_end_location();
+        } catch (const runtime_error&) {
+        }
+    }
+    if (!loaded) {
+        field.reset(new DistanceField(maze, maze.get_end_location()));
+        if (!field_file.empty()) {
+            field->save(field_file);
+        }
+    }
+    auto build_end = chrono::steady_clock::now();
+
+    Random random(seed);
+    vector<pair<int,int>> agents(agent_count);
+    uint64_t total_distance = 0;
+    for (pair<int,int>& agent : agents) {
+        agent = make_pair(random.next_below(maze.get_height()), random.next_below(maze.get_width()));
+        if (field->get_distance(agent) != DistanceField::UNREACHABLE) {
+            total_distance += field->get_distance(agent);
+        }
+    }
+    // agents that can't reach the exit stay where they are
+    auto walk_start = chrono::steady_clock::now();
+    uint64_t lookups = 0;
+    for (pair<int,int>& agent : agents) {
+        for (uint32_t steps = field->get_distance(agent); steps != DistanceField::UNREACHABLE && steps > 0; --steps) {
+            agent = field->get_next_cell(agent);
+            ++lookups;
+        }
+    }
+    auto walk_end = chrono::steady_clock::now();
+
+    double walk_seconds = chrono::duration<double>(walk_end - walk_start).count();
+    cerr << "distance field: " << chrono::duration<double>(build_end - build_start).count() << " s to "
+         << (loaded ? "load" : "build") << ", " << total_distance / max(agent_count, 1) << " steps to the exit on average, "
+         << lookups / max(walk_seconds, 1e-9) / 1e6 << " M lookups per second" << endl;
+}
+
+/*
+* Solves a tiled maze file with at most memory_mb of cached tiles and writes one record.
+* The I/O counts of the caches go to stderr.
+* Throws std::runtime_error if a file can't be read or written.
+*/
+void solve_tiled_maze(const string& filename, size_t memory_mb, string scratch_directory, ReportFormat format) {
+    if (scratch_directory.empty()) {
+        size_t slash = filename.rfind('/');
+        scratch_directory = slash == string::npos ? "." : filename.substr(0, max<size_t>(slash, 1));
+    }
+    // a block of visited bits is half a tile of walls, so this split caches as many of both
+    size_t memory = memory_mb << 20;
+    TiledMaze maze(filename, memory / 3 * 2);
+    TiledSolver solver(scratch_directory, memory / 3);
+
+    auto solve_start = chrono::steady_clock::now();
+    Path path = solver.solve(maze, maze.get_start_location(), maze.get_end_location());
+    auto solve_end = chrono::steady_clock::now();
+
+    const TiledMazeHeader& header = maze.get_header();
+    RunRecord record;
+    record.generator = get_generator_name(static_cast<Maze::Generator>(header.generator));
+    record.solver = "tiled-dfs";
+    record.width = header.width;
+    record.height = header.height;
+    record.seed = header.seed;
+    record.solve_seconds = chrono::duration<double>(solve_end - solve_start).count();
+    record.path_length = path.size();
+    record.nodes_expanded = solver.get_nodes_expanded();
+    write_report(cout, {record}, format);
+
+    const BlockCache::Stats& walls = maze.get_cache_stats();
+    const BlockCache::Stats& visited = solver.get_visited_stats();
+    cerr << "wall tiles: " << maze.get_cache_capacity() << " cached, " << walls.hits << " hits, "
+         << walls.misses << " misses, " << walls.blocks_read << " read ("
+         << (walls.blocks_read * maze.get_tile_bytes() >> 20) << " MB)\n"
+         << "visited blocks: " << visited.hits << " hits, " << visited.misses << " misses, "
+         << visited.blocks_read << " read, " << visited.blocks_written << " written\n"
+         << "path steps: " << (path.get_memory_usage() >> 20) << " MB" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    int width = 30;
+    int height = 20;
+    unsigned long long seed = Random::make_seed();
+    string generator = "dfs";
+    string layout_name = "row-major";
+    string solver = "dfs";
+    ReportFormat format = ReportFormat::CSV;
+    bool display = false;
+    string stream_file;
+    string save_file;
+    string load_file;
+    string batch_file;
+    string tiled_file;
+    size_t memory_mb = DEFAULT_TILED_MEMORY_MB;
+    string scratch_directory;
+    int threads = 0;
+    string image_file;
+    string image_format_name;
+    string trace_file;
+    double braid = 0;
+    int query_count = 0;
+    int agent_count = 0;
+    string field_file;
+    int tick_count = 0;
+    int edit_count = DEFAULT_EDITS_PER_TICK;
+    string archive_file;
+    int archive_count = 1;
+    long long extract_index = -1;
+
+    // stoi and friends throw on values that are not numbers or out of range
+    try {
+        for (int i = 1; i < argc; ++i) {
+            bool has_value = i + 1 < argc;
+            if (strcmp(argv[i], "--width") == 0 && has_value) {
+                width = stoi(argv[++i]);
+            } else if (strcmp(argv[i], "--height") == 0 && has_value) {
+                height = stoi(argv[++i]);
+            } else if (strcmp(argv[i], "--seed") == 0 && has_value) {
+                seed = stoull(argv[++i]);
+            } else if (strcmp(argv[i], "--layout") == 0 && has_value) {
+                layout_name = argv[++i];
+            } else if (strcmp(argv[i], "--generator") == 0 && has_value) {
+                generator = argv[++i];
+            } else if (strcmp(argv[i], "--solver") == 0 && has_value) {
+                solver = argv[++i];
+            } else if (strcmp(argv[i], "--format") == 0 && has_value) {
+                if (!parse_report_format(argv[++i], format)) {
+                    cerr << "Unknown format " << argv[i] << endl;
+                    return 1;
+                }
+            } else if (strcmp(argv[i], "--stream") == 0 && has_value) {
+                stream_file = argv[++i];
+            } else if (strcmp(argv[i], "--save") == 0 && has_value) {
+                save_file = argv[++i];
+            } else if (strcmp(argv[i], "--load") == 0 && has_value) {
+                load_file = argv[++i];
+            } else if (strcmp(argv[i], "--braid") == 0 && has_value) {
+                braid = stod(argv[++i]);
+            } else if (strcmp(argv[i], "--queries") == 0 && has_value) {
+                query_count = stoi(argv[++i]);
+            } else if (strcmp(argv[i], "--agents") == 0 && has_value) {
+                agent_count = stoi(argv[++i]);
+            } else if (strcmp(argv[i], "--ticks") == 0 && has_value) {
+                tick_count = stoi(argv[++i]);
+            } else if (strcmp(argv[i], "--edits") == 0 && has_value) {
+                edit_count = stoi(argv[++i]);
+            } else if (strcmp(argv[i], "--field") == 0 && has_value) {
+                field_file = argv[++i];
+            } else if (strcmp(argv[i], "--archive") == 0 && has_value) {
+                archive_file = argv[++i];
+            } else if (strcmp(argv[i], "--count") == 0 && has_value) {
+                archive_count = stoi(argv[++i]);
+            } else if (strcmp(argv[i], "--extract") == 0 && has_value) {
+                extract_index = stoll(argv[++i]);
+            } else if (strcmp(argv[i], "--tiled") == 0 && has_value) {
+                tiled_file = argv[++i];
+            } else if (strcmp(argv[i], "--memory-mb") == 0 && has_value) {
+                memory_mb = stoull(argv[++i]);
+            } else if (strcmp(argv[i], "--scratch") == 0 && has_value) {
+                scratch_directory = argv[++i];
+            } else if (strcmp(argv[i], "--batch") == 0 && has_value) {
+                batch_file = argv[++i];
+            } else if (strcmp(argv[i], "--threads") == 0 && has_value) {
+                threads = stoi(argv[++i]);
+            } else if (strcmp(argv[i], "--image") == 0 && has_value) {
+                image_file = argv[++i];
+            } else if (strcmp(argv[i], "--image-format") == 0 && has_value) {
+                image_format_name = argv[++i];
+            } else if (strcmp(argv[i], "--trace") == 0 && has_value) {
+                trace_file = argv[++i];
+            } else if (strcmp(argv[i], "--display") == 0) {
+                display = true;
+            } else {
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+    } catch (const logic_error&) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    if (!batch_file.empty()) {
+        try {
+            auto batch_start = chrono::steady_clock::now();
+            run_batch(batch_file, threads, format);
+            auto batch_end = chrono::steady_clock::now();
+            cerr << "Batch took " << chrono::duration<double>(batch_end - batch_start).count() << " s" << endl;
+        } catch (const invalid_argument& error) {
+            cerr << error.what() << endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    if (!tiled_file.empty()) {
+        try {
+            solve_tiled_maze(tiled_file, memory_mb, scratch_directory, format);
+        } catch (const runtime_error& error) {
+            cerr << error.what() << endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    if (width <= 0 || height <= 0) {
+        cerr << "Width and height must be positive" << endl;
+        return 1;
+    }
+    Maze::Generator maze_generator;
+    if (!parse_generator(generator, maze_generator)) {
+        cerr << "Unknown generator " << generator << endl;
+        return 1;
+    }
+    WallGrid::Layout layout;
+    if (!parse_layout(layout_name, layout)) {
+        cerr << "Unknown layout " << layout_name << endl;
+        return 1;
+    }
+    unique_ptr<Solver> maze_solver = make_solver(solver);
+    if (!maze_solver) {
+        cerr << "Unknown solver " << solver << endl;
+        return 1;
+    }
+    ImageFormat image_format = ImageFormat::PNG;
+    if (!image_format_name.empty()) {
+        if (!parse_image_format(image_format_name, image_format)) {
+            cerr << "Unknown image format " << image_format_name << endl;
+            return 1;
+        }
+    } else if (!image_file.empty() && image_file != "-" && !get_image_format_from_extension(image_file, image_format)) {
+        cerr << "Unknown image format of " << image_file << ", use --image-format" << endl;
+        return 1;
+    }
+
+    if (!archive_file.empty() && extract_index < 0) {
+        if (archive_count <= 0) {
+            cerr << "Count must be positive" << endl;
+            return 1;
+        }
+        try {
+            append_to_archive(archive_file, archive_count, width, height, seed, maze_generator, threads);
+        } catch (const runtime_error& error) {
+            cerr << error.what() << endl;
+            return 1;
+        }
+        return 0;
+    }
+    if (extract_index >= 0 && archive_file.empty()) {
+        cerr << "--extract needs --archive" << endl;
+        return 1;
+    }
+
+    RunRecord record;
+    record.generator = generator;
+    record.solver = solver;
+    record.layout = get_layout_name(layout);
+    record.width = width;
+    record.height = height;
+    record.seed = seed;
+
+    try {
+        if (!stream_file.empty()) {
+            if (generator != "eller") {
+                cerr << "Only the eller generator supports --stream" << endl;
+                return 1;
+            }
+
+            auto generate_start = chrono::steady_clock::now();
+            stream_eller_maze(stream_file, width, height, seed);
+            auto generate_end = chrono::steady_clock::now();
+
+            record.solver = "none";
+            record.generate_seconds = chrono::duration<double>(generate_end - generate_start).count();
+            write_report(cout, {record}, format);
+            return 0;
+        }
+
+#ifdef MAZE_INSTRUMENT
+        Instrumentation& instrumentation = Instrumentation::get();
+        if (!trace_file.empty()) {
+            instrumentation.enable_trace(TRACE_CAPACITY);
+        }
+        instrumentation.reset();
+#else
+        if (!trace_file.empty()) {
+            cerr << "--trace needs a build with -DMAZE_INSTRUMENT" << endl;
+            return 1;
+        }
+#endif
+
+        auto generate_start = chrono::steady_clock::now();
+        // the tree solver reads paths off the spanning tree the generator records
+        bool record_tree = solver == "tree";
+        Maze maze = extract_index >= 0 ? MazeArchive(archive_file).get_maze(extract_index)
+            : load_file.empty() ? Maze(width, height, seed, maze_generator, record_tree, layout) : Maze::open_mapped(load_file);
+        if (braid > 0) {
+            maze.braid(braid);
+        }
+        auto solve_start = chrono::steady_clock::now();
+        if (display) {
+            watch_solve(maze, *maze_solver);
+        } else {
+            maze.set_path(maze_solver->solve(maze, maze.get_start_location(), maze.get_end_location()));
+        }
+        auto solve_end = chrono::steady_clock::now();
+
+        if (!save_file.empty()) {
+            maze.save(save_file);
+        }
+
+        record.generator = get_generator_name(maze.get_generator());
+        record.layout = get_layout_name(maze.get_layout());
+        record.width = maze.get_width();
+        record.height = maze.get_height();
+        record.seed = maze.get_seed();
+        record.generate_seconds = chrono::duration<double>(solve_start - generate_start).count();
+        record.solve_seconds = chrono::duration<double>(solve_end - solve_start).count();
+        record.path_length = maze.get_path().size();
+        record.nodes_expanded = maze_solver->get_nodes_expanded();
+
+        if (!image_file.empty()) {
+            export_image(maze, image_file, image_format);
+        }
+
+        if (query_count > 0) {
+            run_queries(maze, query_count, edit_count, maze.get_seed());
+        }
+
+        if (agent_count > 0) {
+            run_agents(maze, agent_count, field_file, maze.get_seed());
+        }
+
+        if (tick_count > 0) {
+            run_ticks(maze, tick_count, edit_count, maze.get_seed());
+        }
+
+#ifdef MAZE_INSTRUMENT
+        instrumentation.write_counters(cerr);
+        if (!trace_file.empty()) {
+            ofstream trace_out(trace_file);
+            instrumentation.write_trace(trace_out);
+            if (!trace_out) {
+                throw runtime_error("Could not write " + trace_file);
+            }
+        }
+#endif
+
+        if (!display && image_file != "-") {
+            write_report(cout, {record}, format);
+        }
+    } catch (const runtime_error& error) {
+        cerr << error.what() << endl;
+        return 1;
+    } catch (const out_of_range& error) {
+        cerr << error.what() << endl;
+        return 1;
+    }
 }